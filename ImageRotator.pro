@@ -4,26 +4,17 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+# The pixel work lives in a headless static library (rotationengine.pro)
+# that the GUI (gui.pro) and the checks (rotationengine_test.pro) link against.
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+TEMPLATE = subdirs
 
-TARGET = ImageRotator
-TEMPLATE = app
+SUBDIRS += rotationengine \
+    gui \
+    rotationengine_test
 
-
-SOURCES += main.cpp\
-        mainwindow.cpp \
-    graphicssceneex.cpp \
-    graphicsviewex.cpp \
-    io.cpp \
-    text.cpp
-
-HEADERS  += mainwindow.h \
-    graphicssceneex.h \
-    graphicsviewex.h \
-    io.h \
-    text.h \
-    extcolordefs.h
-
-FORMS    += mainwindow.ui
+rotationengine.file = rotationengine.pro
+gui.file = gui.pro
+gui.depends = rotationengine
+rotationengine_test.file = rotationengine_test.pro
+rotationengine_test.depends = rotationengine
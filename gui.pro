@@ -0,0 +1,45 @@
+#-------------------------------------------------
+#
+# ImageRotator GUI, a thin client of the rotation engine
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = ImageRotator
+TEMPLATE = app
+CONFIG += c++11 thread
+
+
+SOURCES += main.cpp\
+        mainwindow.cpp \
+    graphicssceneex.cpp \
+    graphicsviewex.cpp \
+    io.cpp \
+    text.cpp \
+    tiledimageitem.cpp
+
+HEADERS  += mainwindow.h \
+    graphicssceneex.h \
+    graphicsviewex.h \
+    io.h \
+    text.h \
+    tiledimageitem.h \
+    extcolordefs.h
+
+FORMS    += mainwindow.ui
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/release/ -lrotationengine
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/debug/ -lrotationengine
+else:unix: LIBS += -L$$OUT_PWD/ -lrotationengine
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/librotationengine.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/librotationengine.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/rotationengine.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/rotationengine.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/librotationengine.a
@@ -22,13 +22,33 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(ui->saveAsBtn,SIGNAL(clicked(bool)),this,SLOT(saveAsBtnClicked()));
     connect(ui->fitToWindowBtn,SIGNAL(clicked(bool)),this,SLOT(fitToWindow()));
     connect(ui->resetZoomBtn,SIGNAL(clicked(bool)),this,SLOT(resetZoom()));
-    image=0;
-    scene=new QGraphicsScene();
-    pixmapItem=new QGraphicsPixmapItem();
-    scene->addItem(pixmapItem);
+    scene=new QGraphicsScene(this); // Deletes the display with it, which stops its worker thread
+    imageItem=new TiledImageItem();
+    scene->addItem(imageItem);
     ui->graphicsView->setScene(scene);
-    originalImageData=0;
-    currentNonRotatedImageData=0;
+    originalImageBuffer=0;
+    for(int i=0;i<PYRAMID_LEVELS;i++)
+        pyramidBuffers[i]=0;
+    pyramidLevels=0;
+    pyramidCancelled=false;
+    resultWidth=0;
+    resultHeight=0;
+    fitPending=false;
+    backgroundColor=Qt::white;
+    saveCancelled=false;
+    saveGeneration=0;
+    saving=false;
+
+    // Edits only start this timer, so that several edits in a row are rendered once, when control returns to the event loop
+
+    renderTimer=new QTimer(this);
+    renderTimer->setSingleShot(true);
+    renderTimer->setInterval(0);
+    connect(renderTimer,SIGNAL(timeout()),this,SLOT(renderImage()));
+    connect(ui->methodBox,SIGNAL(currentIndexChanged(int)),this,SLOT(renderSettingsChanged()));
+    connect(ui->borderBox,SIGNAL(currentIndexChanged(int)),this,SLOT(renderSettingsChanged()));
+    connect(ui->backgroundColorBtn,SIGNAL(clicked(bool)),this,SLOT(backgroundColorBtnClicked()));
+    connect(ui->cropBox,SIGNAL(toggled(bool)),this,SLOT(cropBoxToggled()));
 
     connect(ui->resetBtn,SIGNAL(clicked(bool)),this,SLOT(resetBtnClicked()));
     connect(ui->flipVerticallyBtn,SIGNAL(clicked(bool)),this,SLOT(flipVerticallyBtnClicked()));
@@ -40,8 +60,14 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
-    free(originalImageData);
-    free(currentNonRotatedImageData);
+    if(saving)
+    {
+        saveCancelled=true;
+        saveThread.join();
+    }
+    imageItem->clear();
+    stopPyramid();
+    free(originalImageBuffer);
     delete ui;
 }
 
@@ -64,44 +90,109 @@ void MainWindow::loadBtnClicked()
         QMessageBox::critical(this,"Error","The selected file does not exist.");
         return;
     }
-    delete image;
-    image=new QImage(path);
-    if(image->isNull())
+    QImage loadedImage(path);
+    if(loadedImage.isNull())
     {
         QMessageBox::critical(this,"Error","The selected file has an unsupported format.");
         return;
     }
-    currentDegs=0;
-    originalImageWidth=image->width();
-    originalImageHeight=image->height();
-    scene->setSceneRect(0,0,originalImageWidth,originalImageHeight);
-    free(originalImageData);
-    free(currentNonRotatedImageData);
-    originalImageData=qImageToBitmapData(image);
-    size_t imageDataSize=originalImageWidth*originalImageHeight*sizeof(uint32_t);
-    currentNonRotatedImageData=(uint32_t*)malloc(imageDataSize);
-    memcpy(currentNonRotatedImageData,originalImageData,imageDataSize);
-    pixmapItem->setPixmap(QPixmap::fromImage(*image));
-    ui->graphicsView->viewport()->update();
-    fitToWindow();
+    renderTimer->stop();
+    imageItem->clear();
+    stopPyramid();
+    originalImageWidth=loadedImage.width();
+    originalImageHeight=loadedImage.height();
+    free(originalImageBuffer);
+    uint32_t *data=qImageToBitmapData(&loadedImage);
+    originalImageBuffer=RotationEngine::padImage(data,originalImageWidth,originalImageHeight,originalImage);
+    free(data);
+
+    // Until its reduced copies are built, the display renders from the finest level there is
+
+    pyramid[0]=originalImage;
+    pyramidLevels=1;
+    pyramidCancelled=false;
+    pyramidThread=std::thread(&MainWindow::buildPyramid,this);
+    operations.clear();
+    fitPending=true;
+    renderImage();
 }
 
 void MainWindow::saveAsBtnClicked()
 {
-    if(currentNonRotatedImageData==0)
+    // While saving, the button cancels the save. It stays disabled until the render stops, at the end of a band of rows.
+
+    if(saving)
+    {
+        saveCancelled=true;
+        saveGeneration++;
+        ui->saveAsBtn->setEnabled(false);
+        return;
+    }
+    if(originalImageBuffer==0)
         return;
     QString path=QFileDialog::getSaveFileName(this,"Save as...",QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),"JPG image (*.jpg);;PNG image (*.png);;GIF image (*.gif);;Bitmap (*.bmp)");
     if(path=="")
         return;
-    image->save(path,0,100);
+
+    // The edits are captured now, so the window stays usable; only loading, which frees the loaded image, waits for the save
+
+    saving=true;
+    saveCancelled=false;
+    ui->saveAsBtn->setText("Cancel saving");
+    ui->loadBtn->setEnabled(false);
+    ui->browseBtn->setEnabled(false);
+    saveThread=std::thread(&MainWindow::saveImage,this,captureSettings(),path,saveGeneration);
+}
+
+void MainWindow::saveImage(const RenderSettings &settings, const QString &path, int generation)
+{
+    // Runs on saveThread. The display may have been rendered at a reduced scale; the file always gets the full-size result.
+    // QImage::save() unpremultiplies only if the file format stores alpha.
+    // The loaded image is rendered from again after saving, so it is never transformed in place itself; only saving an unedited
+    // image needs no second buffer.
+
+    RotationEngine::setCancelFlag(&saveCancelled);
+    int width,height,stride;
+    uint32_t *data=renderOperations(settings,width,height,stride);
+    bool saved=false;
+    if(data!=0&&!saveCancelled)
+    {
+        // QSaveFile only replaces the file once the image is written completely, and deletes what it wrote otherwise; a save
+        // cancelled while writing is thus not committed either. A device has no file name, so the format is given by the suffix.
+
+        QSaveFile file(path);
+        QImage image((uchar*)data,width,height,stride*sizeof(uint32_t),QImage::Format_ARGB32_Premultiplied);
+        if(file.open(QIODevice::WriteOnly)&&image.save(&file,QFileInfo(path).suffix().toLatin1().constData(),100)&&!saveCancelled)
+            saved=file.commit();
+    }
+    if(data!=originalImage.data)
+        free(data);
+    QMetaObject::invokeMethod(this,"saveFinished",Qt::QueuedConnection,Q_ARG(int,generation),Q_ARG(bool,saved));
+}
+
+void MainWindow::saveFinished(int generation, bool saved)
+{
+    saveThread.join();
+    saving=false;
+    ui->saveAsBtn->setText("Save as...");
+    ui->saveAsBtn->setEnabled(true);
+    ui->loadBtn->setEnabled(true);
+    ui->browseBtn->setEnabled(true);
+    if(generation==saveGeneration&&!saved)
+        QMessageBox::critical(this,"Error","The image could not be saved.");
 }
 
 void MainWindow::fitToWindow()
 {
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
-    int width=image->width();
-    int height=image->height();
+    fitZoom();
+}
+
+void MainWindow::fitZoom()
+{
+    int width=resultWidth;
+    int height=resultHeight;
     QRect rect=ui->graphicsView->contentsRect();
     int availableWidth=rect.width()-ui->graphicsView->verticalScrollBar()->width();
     int availableHeight=rect.height()-ui->graphicsView->horizontalScrollBar()->height();
@@ -128,403 +219,305 @@ void MainWindow::rotateBtnClicked()
 {
     // Floating point values may fluctuate; always compare using integers
 
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
     int enteredDegValue=ui->degBox->value()%360;
-    currentDegs+=enteredDegValue;
-
-    rotateImage();
+    addOperation(ImageOperation::Rotate,enteredDegValue);
 }
 
 void MainWindow::rotate45DegLeftBtnClicked()
 {
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
-    currentDegs-=45;
-    rotateImage();
+    addOperation(ImageOperation::Rotate,-45);
 }
 
 void MainWindow::rotate45DegRightBtnClicked()
 {
 
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
-    currentDegs+=45;
-    rotateImage();
+    addOperation(ImageOperation::Rotate,45);
 }
 
 void MainWindow::flipVerticallyBtnClicked()
 {
-    // Note that this will discard the current rotation
+    // Note that this will discard the current rotation (see composeOperations())
 
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
-    currentDegs=0;
-
-    uint32_t *newImageData=(uint32_t*)malloc(originalImageWidth*originalImageHeight*sizeof(uint32_t));
-    int yPos=originalImageHeight;
-    for(int y=0;y<originalImageHeight;y++)
-    {
-        yPos--;
-        int origOffset=yPos*originalImageWidth;
-        int offset=y*originalImageWidth;
-        for(int x=0;x<originalImageWidth;x++)
-        {
-            // Do not use originalImageData; use currentNonRotatedImageData.
-            newImageData[offset+x]=currentNonRotatedImageData[origOffset+x];
-        }
-    }
-    free(currentNonRotatedImageData);
-    currentNonRotatedImageData=newImageData;
-    delete image;
-    image=new QImage((uchar*)newImageData,originalImageWidth,originalImageHeight,QImage::Format_ARGB32);
-    pixmapItem->setPixmap(QPixmap::fromImage(*image));
-    scene->setSceneRect(0,0,originalImageWidth,originalImageHeight);
-    ui->graphicsView->viewport()->update();
-    fitToWindow();
+    addOperation(ImageOperation::FlipVertically);
 }
 
 void MainWindow::flipHorizontallyBtnClicked()
 {
-    // Note that this will discard the current rotation
+    // Note that this will discard the current rotation (see composeOperations())
 
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
-    currentDegs=0;
-
-    uint32_t *newImageData=(uint32_t*)malloc(originalImageWidth*originalImageHeight*sizeof(uint32_t));
-    for(int y=0;y<originalImageHeight;y++)
-    {
-        int offset=y*originalImageWidth;
-        int xPos=originalImageWidth;
-        for(int x=0;x<originalImageWidth;x++)
-        {
-            xPos--;
-            // Do not use originalImageData; use the current image's data.
-            newImageData[offset+x]=currentNonRotatedImageData[offset+xPos];
-        }
-    }
-    free(currentNonRotatedImageData);
-    currentNonRotatedImageData=newImageData;
-    delete image;
-    image=new QImage((uchar*)newImageData,originalImageWidth,originalImageHeight,QImage::Format_ARGB32);
-    pixmapItem->setPixmap(QPixmap::fromImage(*image));
-    scene->setSceneRect(0,0,originalImageWidth,originalImageHeight);
-    ui->graphicsView->viewport()->update();
-    fitToWindow();
+    addOperation(ImageOperation::FlipHorizontally);
 }
 
 void MainWindow::resetBtnClicked()
 {
-    if(image==0||image->isNull())
+    if(originalImageBuffer==0)
         return;
 
-    currentDegs=0;
+    operations.clear();
+    fitPending=true;
+    renderTimer->start();
+}
 
-    delete image;
-    image=new QImage((uchar*)originalImageData,originalImageWidth,originalImageHeight,QImage::Format_ARGB32);
-    free(currentNonRotatedImageData);
-    size_t imageDataSize=originalImageWidth*originalImageHeight*sizeof(uint32_t);
-    currentNonRotatedImageData=(uint32_t*)malloc(imageDataSize);
-    memcpy(currentNonRotatedImageData,originalImageData,imageDataSize);
-    pixmapItem->setPixmap(QPixmap::fromImage(*image));
-    scene->setSceneRect(0,0,originalImageWidth,originalImageHeight);
-    ui->graphicsView->viewport()->update();
-    fitToWindow();
+void MainWindow::renderSettingsChanged()
+{
+    if(originalImageBuffer!=0)
+        renderTimer->start();
 }
 
+void MainWindow::backgroundColorBtnClicked()
+{
+    // The parentheses stop extcolordefs.h's getColor macro from expanding here.
+
+    QColor color=(QColorDialog::getColor)(backgroundColor,this,"Background color");
+    if(!color.isValid())
+        return;
+    backgroundColor=color;
+    if(ui->borderBox->currentIndex()==RotationEngine::BorderConstant)
+        renderSettingsChanged();
+}
 
-void MainWindow::rotateImage()
+void MainWindow::cropBoxToggled()
 {
-    if(currentDegs<0)
-        currentDegs=360-(abs(currentDegs)%360);
-    if(currentDegs>=360)
-        currentDegs-=360;
+    if(originalImageBuffer==0)
+        return;
+    fitPending=true;
+    renderTimer->start();
+}
+
+void MainWindow::addOperation(ImageOperation::Type type, int degs)
+{
+    ImageOperation operation;
+    operation.type=type;
+    operation.degs=degs;
+    operations.append(operation);
+    fitPending=true;
+    renderTimer->start();
+}
 
-    decimal_t degsToRotate=(((decimal_t)currentDegs)/180.0f)*M_PI;
-    uint32_t *newImageData;
-    int newImageWidth;
-    int newImageHeight;
+AffineTransform MainWindow::composeOperations(int &newWidth, int &newHeight, int &degs, bool &flipped) const
+{
+    // Flips apply to the non-rotated image and discard the rotation, so any list of edits reduces to a flip followed by a rotation
 
-    if(currentDegs%90==0)
+    bool flipVertically=false;
+    bool flipHorizontally=false;
+    degs=0;
+    for(int i=0;i<operations.size();i++)
     {
-        if(currentDegs==0)
-        {
-            currentDegs=0;
-            // The current image may be rotated; restore currentNonRotatedImageData
-            newImageWidth=originalImageWidth;
-            newImageHeight=originalImageHeight;
-            size_t imageDataSize=newImageWidth*newImageHeight*sizeof(uint32_t);
-            newImageData=(uint32_t*)malloc(imageDataSize);
-            memcpy(newImageData,currentNonRotatedImageData,imageDataSize);
-        }
-        else if(currentDegs==90)
-        {
-            // Flip to right
-
-            newImageWidth=originalImageHeight;
-            newImageHeight=originalImageWidth;
-            newImageData=(uint32_t*)malloc(newImageWidth*newImageHeight*sizeof(uint32_t));
-
-            for(int y=0;y<newImageHeight;y++)
-            {
-                int offset=y*newImageWidth;
-                int currentX=originalImageHeight;
-                for(int x=0;x<newImageWidth;x++)
-                {
-                    currentX--;
-                    newImageData[offset+x]=currentNonRotatedImageData[currentX*originalImageWidth+y];
-                }
-            }
-        }
-        else if(currentDegs==180)
+        const ImageOperation &operation=operations.at(i);
+        if(operation.type==ImageOperation::Rotate)
+            degs+=operation.degs;
+        else
         {
-            // Not the same as flipping vertically
-
-            newImageWidth=originalImageWidth;
-            newImageHeight=originalImageHeight;
-            newImageData=(uint32_t*)malloc(newImageWidth*newImageHeight*sizeof(uint32_t));
-
-            int currentY=originalImageHeight;
-            for(int y=0;y<newImageHeight;y++)
-            {
-                currentY--;
-                int origOffset=currentY*newImageWidth;
-                int offset=y*newImageWidth;
-                int currentX=originalImageWidth;
-                for(int x=0;x<newImageWidth;x++)
-                {
-                    currentX--;
-                    newImageData[offset+x]=currentNonRotatedImageData[origOffset+currentX];
-                }
-            }
-        }
-        else if(currentDegs==270)
-        {
-            // Flip to left
-
-            newImageWidth=originalImageHeight;
-            newImageHeight=originalImageWidth;
-            newImageData=(uint32_t*)malloc(newImageWidth*newImageHeight*sizeof(uint32_t));
-
-            int currentY=newImageHeight;
-            for(int y=0;y<newImageHeight;y++)
-            {
-                currentY--;
-                int offset=currentY*newImageWidth;
-                for(int x=0;x<newImageWidth;x++)
-                {
-                    newImageData[offset+x]=currentNonRotatedImageData[x*originalImageWidth+y];
-                }
-            }
+            if(operation.type==ImageOperation::FlipVertically)
+                flipVertically=!flipVertically;
+            else
+                flipHorizontally=!flipHorizontally;
+            degs=0;
         }
     }
-    else
-    {
-        decimal_t rightmostPossibleX=originalImageWidth-1;
-        decimal_t bottommostPossibleY=originalImageHeight-1;
-
-        // Both images share the same center
-
-        decimal_t centerX=rightmostPossibleX*0.5;
-        decimal_t centerY=bottommostPossibleY*0.5;
-
-        // Calculate new edge points' positions and extract image size from them
-
-        // These edge distances stay the same as the image is rotated
-
-        decimal_t dTopLeftEdge=sqrt(pow2(centerX)+pow2(centerY));
-        decimal_t dTopRightEdge=sqrt(pow2(centerX-rightmostPossibleX)+pow2(centerY));
-        decimal_t dBottomLeftEdge=sqrt(pow2(centerX)+pow2(centerY-bottommostPossibleY));
-        decimal_t dBottomRightEdge=sqrt(pow2(centerX-rightmostPossibleX)+pow2(centerY-bottommostPossibleY));
-
-        // Calculate the new positions of these points (needed to determine the new image's dimensions)
-
-        decimal_t topLeftAngle=atan(decimalDiv(centerY,centerX));
-        decimal_t topLeftX=(centerX-cos(topLeftAngle+degsToRotate)*dTopLeftEdge);
-        decimal_t topLeftY=(centerY-sin(topLeftAngle+degsToRotate)*dTopLeftEdge);
-
-        decimal_t topRightAngle=atan(decimalDiv(rightmostPossibleX-centerX,centerY));
-        decimal_t topRightX=(centerX+sin(topRightAngle+degsToRotate)*dTopRightEdge);
-        decimal_t topRightY=(centerY-cos(topRightAngle+degsToRotate)*dTopRightEdge);
-
-        decimal_t bottomLeftAngle=atan(decimalDiv(centerX,bottommostPossibleY-centerY));
-        decimal_t bottomLeftX=(centerX-sin(bottomLeftAngle+degsToRotate)*dBottomLeftEdge);
-        decimal_t bottomLeftY=(centerY+cos(bottomLeftAngle+degsToRotate)*dBottomLeftEdge);
+    degs=RotationEngine::normalizeDegs(degs);
+    flipped=flipVertically||flipHorizontally;
+
+    AffineTransform flip;
+    flip.m11=flipHorizontally?-1.0:1.0;
+    flip.m12=0.0;
+    flip.dx=flipHorizontally?originalImageWidth-1:0;
+    flip.m21=0.0;
+    flip.m22=flipVertically?-1.0:1.0;
+    flip.dy=flipVertically?originalImageHeight-1:0;
+    AffineTransform matrix=RotationEngine::combineTransforms(flip,RotationEngine::rotationTransform(originalImageWidth,originalImageHeight,degs,newWidth,newHeight));
+    if(!ui->cropBox->isChecked()||degs%90==0)
+        return matrix;
+
+    // The flipped source covers the same area, so the rectangle only depends on the rotation. Pixels outside it are never rendered.
+
+    int x,y;
+    RotationEngine::getInscribedRectangle(originalImageWidth,originalImageHeight,degs,x,y,newWidth,newHeight);
+    matrix.dx-=x;
+    matrix.dy-=y;
+    return matrix;
+}
 
-        decimal_t bottomRightAngle=atan(decimalDiv(bottommostPossibleY-centerY,rightmostPossibleX-centerX));
-        decimal_t bottomRightX=(centerX+cos(bottomRightAngle+degsToRotate)*dBottomRightEdge);
-        decimal_t bottomRightY=(centerY+sin(bottomRightAngle+degsToRotate)*dBottomRightEdge);
+int MainWindow::renderMethod(int method, double scale, int degs)
+{
+    // Quarter turns and flips map pixel centers onto pixel centers, where every method reproduces the source;
+    // nearest neighbor is the cheapest
 
-        decimal_t leftmostX=(__min(topLeftX,__min(topRightX,__min(bottomLeftX,bottomRightX))));
-        decimal_t topmostY=(__min(topLeftY,__min(topRightY,__min(bottomLeftY,bottomRightY))));
-        decimal_t rightmostX=(__max(topLeftX,__max(topRightX,__max(bottomLeftX,bottomRightX))));
-        decimal_t bottommostY=(__max(topLeftY,__max(topRightY,__max(bottomLeftY,bottomRightY))));
+    if(method==-1||(scale==1.0&&degs%90==0))
+        method=RotationEngine::NearestNeighbor;
+    return method;
+}
 
-        // This is calculated correctly:
+AffineTransform MainWindow::scalingTransform(double scale)
+{
+    // Scaling about pixel edges: full-size pixel x covers [x-0.5,x+0.5], scaled pixel x' covers [(x'-0.5)/scale,(x'+0.5)/scale]
+
+    AffineTransform scaling;
+    scaling.m11=scale;
+    scaling.m12=0.0;
+    scaling.dx=0.5*scale-0.5;
+    scaling.m21=0.0;
+    scaling.m22=scale;
+    scaling.dy=0.5*scale-0.5;
+    return scaling;
+}
 
-        newImageWidth=ceil(rightmostX-leftmostX);
-        newImageHeight=ceil(bottommostY-topmostY);
+RenderSettings MainWindow::captureSettings() const
+{
+    RenderSettings settings;
+    settings.matrix=composeOperations(settings.width,settings.height,settings.degs,settings.flipped);
+    settings.cropped=ui->cropBox->isChecked();
+
+    // The methods of methodBox, in its order. Three shears are not offered: they take about twice as long as bilinear
+    // resampling for a result that is no sharper.
+
+    static const int boxMethods[]={RotationEngine::NearestNeighbor,RotationEngine::Bilinear,RotationEngine::Bicubic,RotationEngine::Lanczos3};
+    int index=ui->methodBox->currentIndex();
+    settings.method=index<0?-1:boxMethods[index];
+    settings.border=__max(ui->borderBox->currentIndex(),0);
+    settings.borderColor=qPremultiply(backgroundColor.rgba());
+    return settings;
+}
 
-        newImageData=(uint32_t*)calloc(newImageWidth*newImageHeight,sizeof(uint32_t));
+uint32_t *MainWindow::renderOperations(const RenderSettings &settings, int &width, int &height, int &stride) const
+{
+    // Renders the full-size result. Returns the pixels of originalImage itself if there is nothing to do; stride is the distance
+    // between rows in pixels.
 
-        int method=ui->methodBox->currentIndex();
+    width=settings.width;
+    height=settings.height;
+    if(settings.degs==0&&!settings.flipped)
+    {
+        stride=originalImage.stride;
+        return (uint32_t*)originalImage.data;
+    }
 
-        if(method==-1)
-            method=0;
+    // Flips and half turns keep every pixel. They reverse rows of a copy of the loaded image in place, which is about three times
+    // faster than resampling it; the copy belongs to this render, so nothing else sees it change.
 
-        if(method==0) // Nearest neighbor
+    if(settings.degs%180==0)
+    {
+        bool mirrorX=settings.matrix.m11<0.0;
+        bool mirrorY=settings.matrix.m22<0.0;
+        if(!mirrorX&&!mirrorY) // Both flips and a half turn cancel out
         {
-            for(int y=0;y<newImageHeight;y++)
-            {
-                decimal_t dY=(decimal_t)y+topmostY;
-                int offset=y*newImageWidth;
-                for(int x=0;x<newImageWidth;x++)
-                {
-                    decimal_t dX=(decimal_t)x+leftmostX;
-                    decimal_t origX,origY;
-                    int rOrigX,rOrigY;
-
-                    // A point's distance to the center remains the same in both images
-
-                    decimal_t distanceToCenter=sqrt(pow2(centerX-dX)+pow2(centerY-dY));
-                    decimal_t newAngle;
-
-                    newAngle=atan2(centerY-dY,centerX-dX);
-                    origX=(centerX-distanceToCenter*cos(newAngle-degsToRotate));
-                    origY=(centerY-distanceToCenter*sin(newAngle-degsToRotate));
+            stride=originalImage.stride;
+            return (uint32_t*)originalImage.data;
+        }
+        uint32_t *data=RotationEngine::bitmapDataFromScanLines((const uint8_t*)originalImage.data,originalImage.stride*sizeof(uint32_t),width,height);
+        if(mirrorX&&mirrorY)
+            RotationEngine::rotate180InPlace(data,width,height);
+        else if(mirrorX)
+            RotationEngine::flipHorizontallyInPlace(data,width,height);
+        else
+            RotationEngine::flipVerticallyInPlace(data,width,height);
+        stride=width;
+        return data;
+    }
 
-                    // Round at the last step
+    int method=renderMethod(settings.method,1.0,settings.degs);
+    stride=width;
+    return RotationEngine::transform(originalImage,settings.matrix,width,height,method,RotationEngine::DoublePrecision,settings.border,settings.borderColor);
+}
 
-                    rOrigX=round(origX);
-                    rOrigY=round(origY);
+uint32_t *MainWindow::renderRegion(const RenderSettings &settings, double scale, int x, int y, int width, int height) const
+{
+    // Renders one tile of the display: the window at (x,y) of the result scaled by "scale", in one pass from the pyramid level
+    // of the same scale, or the finest one built yet. Resampling the full size would skip most of the pixels a scaled pixel
+    // covers, where the level has averaged all of them; the edits then only map it at about its own size.
+    // Runs on the display's worker thread.
+
+    int level=0;
+    int levels=pyramidLevels;
+    while(level+1<levels&&scale*(1<<(level+1))<=1.0)
+        level++;
+
+    AffineTransform matrix=RotationEngine::combineTransforms(settings.matrix,scalingTransform(scale));
+    matrix=RotationEngine::combineTransforms(scalingTransform(1<<level),matrix);
+    matrix.dx-=x;
+    matrix.dy-=y;
+    int method=renderMethod(settings.method,scale*(1<<level),settings.degs);
+    return RotationEngine::transform(pyramid[level],matrix,width,height,method,RotationEngine::DoublePrecision,settings.border,settings.borderColor);
+}
 
-                    // Check whether point exists
+void MainWindow::buildPyramid()
+{
+    // Runs on pyramidThread. Each level reads the previous one, so all of them together cost about a third more than reading
+    // the loaded image once. A cancelled build stops between levels.
 
-                    if(rOrigX<0||rOrigX>=originalImageWidth||rOrigY<0||rOrigY>=originalImageHeight)
-                        continue;
+    for(int level=1;level<PYRAMID_LEVELS&&!pyramidCancelled;level++)
+    {
+        const SourceImage &previous=pyramid[level-1];
+        if(previous.width==1&&previous.height==1)
+            break;
+        pyramidBuffers[level]=RotationEngine::halveImage(previous,pyramid[level]);
+        pyramidLevels=level+1;
+        QMetaObject::invokeMethod(this,"pyramidLevelBuilt",Qt::QueuedConnection,Q_ARG(int,level));
+    }
+}
 
-                    newImageData[offset+x]=currentNonRotatedImageData[rOrigY*originalImageWidth+rOrigX];
-                }
-            }
-        }
-        else if(method==1) // Bilinear
-        {
-            int xLim=originalImageWidth-1;
-            int yLim=originalImageHeight-1;
-            for(int y=0;y<newImageHeight;y++)
-            {
-                decimal_t dY=(decimal_t)y+topmostY;
-                int offset=y*newImageWidth;
-                for(int x=0;x<newImageWidth;x++)
-                {
-                    decimal_t dX=(decimal_t)x+leftmostX;
-                    decimal_t origX,origY;
-                    int rOrigX,rOrigY; // round
-                    int fOrigX,fOrigY; // floor
-                    int cOrigX,cOrigY; // ceiling
-
-                    // A point's distance to the center remains the same in both images
-
-                    decimal_t distanceToCenter=sqrt(pow2(centerX-dX)+pow2(centerY-dY));
-                    decimal_t newAngle;
-
-                    newAngle=atan2(centerY-dY,centerX-dX);
-                    origX=(centerX-distanceToCenter*cos(newAngle-degsToRotate));
-                    origY=(centerY-distanceToCenter*sin(newAngle-degsToRotate));
-
-                    // Round at the last step
-
-                    rOrigX=round(origX);
-                    rOrigY=round(origY);
-
-                    fOrigX=floor(__max(origX,0.0f));
-                    fOrigY=floor(__max(origY,0.0f));
-                    cOrigX=ceil(origX);
-                    cOrigY=ceil(origY);
-
-                    // Check whether point exists
-
-                    if(rOrigX<0||rOrigX>=originalImageWidth||rOrigY<0||rOrigY>=originalImageHeight)
-                        continue;
-
-                    const bool checkBounds=fOrigX<=1||cOrigX>=originalImageWidth-2||fOrigY<=1||cOrigY>=originalImageHeight-2;
-
-                    uint32_t c00,c01,c10,c11;
-
-                    if(checkBounds)
-                    {
-                        c00=currentNonRotatedImageData[fOrigY*originalImageWidth+fOrigX];
-                        c10=currentNonRotatedImageData[fOrigY*originalImageWidth+(cOrigX>xLim?fOrigX:cOrigX)];
-                        c01=(cOrigY>yLim?c00:currentNonRotatedImageData[(cOrigY)*originalImageWidth+fOrigX]);
-                        c11=(cOrigY>yLim?c10:(cOrigX>xLim?currentNonRotatedImageData[(cOrigY)*originalImageWidth+fOrigX]:currentNonRotatedImageData[(cOrigY)*originalImageWidth+(cOrigX)]));
-                    }
-                    else
-                    {
-                        c00=currentNonRotatedImageData[fOrigY*originalImageWidth+fOrigX];
-                        c10=currentNonRotatedImageData[fOrigY*originalImageWidth+cOrigX];
-                        c01=currentNonRotatedImageData[(cOrigY)*originalImageWidth+fOrigX];
-                        c11=currentNonRotatedImageData[(cOrigY)*originalImageWidth+(cOrigX)];
-                    }
-
-                    decimal_t xDiff=origX-floor(origX);
-                    decimal_t xDiffR=1.0-xDiff;
-                    decimal_t yDiff=origY-floor(origY);
-                    decimal_t yDiffR=1.0-yDiff;
-
-                    decimal_t w1=xDiffR*yDiffR;
-                    decimal_t w2=xDiff*yDiffR;
-                    decimal_t w3=xDiffR*yDiff;
-                    decimal_t w4=xDiff*yDiff;
-
-                    uint32_t newAlpha=bilinearInterpolate(getAlpha(c00),getAlpha(c01),getAlpha(c10),getAlpha(c11),w1,w2,w3,w4);
-                    uint32_t newRed=bilinearInterpolate(getRed(c00),getRed(c01),getRed(c10),getRed(c11),w1,w2,w3,w4);
-                    uint32_t newGreen=bilinearInterpolate(getGreen(c00),getGreen(c01),getGreen(c10),getGreen(c11),w1,w2,w3,w4);
-                    uint32_t newBlue=bilinearInterpolate(getBlue(c00),getBlue(c01),getBlue(c10),getBlue(c11),w1,w2,w3,w4);
-
-                    newImageData[offset+x]=getColor(newAlpha,newRed,newGreen,newBlue);
-                }
-            }
-        }
+void MainWindow::stopPyramid()
+{
+    pyramidCancelled=true;
+    if(pyramidThread.joinable())
+        pyramidThread.join();
+    for(int i=1;i<PYRAMID_LEVELS;i++)
+    {
+        free(pyramidBuffers[i]);
+        pyramidBuffers[i]=0;
     }
+    pyramidLevels=0;
+}
+
+void MainWindow::pyramidLevelBuilt(int level)
+{
+    // Tiles rendered from a finer level than the new one are replaced, at the scales it serves. They stay on screen until then.
 
-    delete image;
-    image=new QImage((uchar*)newImageData,newImageWidth,newImageHeight,QImage::Format_ARGB32);
-    pixmapItem->setPixmap(QPixmap::fromImage(*image));
-    scene->setSceneRect(0,0,newImageWidth,newImageHeight);
-    ui->graphicsView->viewport()->update();
-    fitToWindow();
+    imageItem->refreshTiles(1.0/(1<<level));
 }
 
-uint32_t *MainWindow::qImageToBitmapData(QImage *image)
+void MainWindow::renderImage()
 {
-    int32_t width=image->width();
-    int32_t height=image->height();
-    uint32_t *out=(uint32_t*)malloc(width*height*sizeof(uint32_t));
-    for(int32_t y=0;y<height;y++)
+    // Called once the edits are needed on screen: composes them and hands the new size to the display, which renders
+    // the tiles it shows in the background. Tiles of the previous edits that are still being rendered are cancelled.
+
+    renderTimer->stop();
+    if(originalImageBuffer==0)
+        return;
+
+    RenderSettings settings=captureSettings();
+    resultWidth=settings.width;
+    resultHeight=settings.height;
+    scene->setSceneRect(0,0,resultWidth,resultHeight);
+    imageItem->setImage(resultWidth,resultHeight,[this,settings](double scale,int x,int y,int width,int height)
     {
-        int32_t offset=y*width;
-        QRgb *scanLine=(QRgb*)image->scanLine(y); // Do not free!
-        for(int32_t x=0;x<width;x++)
-        {
-            QRgb color=scanLine[x];
-            uint32_t alpha=qAlpha(color);
-            uint32_t red=qRed(color);
-            uint32_t green=qGreen(color);
-            uint32_t blue=qBlue(color);
-            out[offset+x]=(alpha<<24)|(red<<16)|(green<<8)|blue;
-        }
-        // Do not free "scanLine"!
+        return renderRegion(settings,scale,x,y,width,height);
+    });
+    if(fitPending)
+    {
+        fitPending=false;
+        fitZoom();
     }
-    return out;
 }
 
-decimal_t MainWindow::bilinearInterpolate(decimal_t c00, decimal_t c10, decimal_t c01, decimal_t c11, decimal_t w1, decimal_t w2, decimal_t w3, decimal_t w4)
+uint32_t *MainWindow::qImageToBitmapData(QImage *image)
 {
-    return w1*c00+w2*c01+w3*c10+w4*c11;
+    // convertToFormat() returns a shallow copy if the image already is in the requested format
+    QImage argbImage=image->convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    return RotationEngine::bitmapDataFromScanLines(argbImage.constBits(),argbImage.bytesPerLine(),argbImage.width(),argbImage.height());
 }
@@ -1,48 +1,102 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
-#ifndef _USE_MATH_DEFINES
-#define _USE_MATH_DEFINES
-#endif
-
 #include <QMainWindow>
 #include <QFileDialog>
 #include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QMessageBox>
 #include <QStandardPaths>
-#include <QGraphicsPixmapItem>
 #include <QStringList>
-#include <math.h>
+#include <QList>
+#include <QTimer>
+#include <QColorDialog>
+#include <thread>
+#include <atomic>
+
+#include "rotationengine.h"
+#include "tiledimageitem.h"
+
+// Reduced copies of the loaded image, each half the size of the previous one, down to MIN_RENDER_SCALE
 
-#include "extcolordefs.h"
+#define PYRAMID_LEVELS 7
 
 namespace Ui {
 class MainWindow;
 }
 
-typedef double decimal_t;
+// An edit recorded by the user interface; edits are only applied to pixels when the result is displayed or saved
 
-#define decimalDiv(a,b) ((decimal_t)(((decimal_t)(a))/((decimal_t)(b))))
+struct ImageOperation
+{
+    enum Type
+    {
+        Rotate,
+        FlipVertically,
+        FlipHorizontally
+    };
+
+    Type type;
+    int degs; // Rotate only
+};
+
+// The edits and settings a render uses, captured on the GUI thread for the thread rendering the tiles or the saved file
+
+struct RenderSettings
+{
+    AffineTransform matrix; // See MainWindow::composeOperations()
+    int width,height; // Full size of the result
+    int degs;
+    bool flipped;
+    bool cropped;
+    int method; // RotationEngine::Method selected in methodBox, -1 if none; see MainWindow::renderMethod()
+    int border;
+    uint32_t borderColor;
+};
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
     QFileDialog *dialog;
-    QImage *image;
     QGraphicsScene *scene;
-    QGraphicsPixmapItem *pixmapItem;
+    TiledImageItem *imageItem;
     int originalImageWidth,originalImageHeight;
-    uint32_t *originalImageData;
-    uint32_t *currentNonRotatedImageData;
-    int currentDegs;
+    uint32_t *originalImageBuffer; // Loaded image with a guard band, see RotationEngine::padImage(); 0 until an image is loaded
+    SourceImage originalImage;
+    SourceImage pyramid[PYRAMID_LEVELS]; // Level n is the loaded image box-filtered to 1/2^n of its size; level 0 is originalImage
+    uint32_t *pyramidBuffers[PYRAMID_LEVELS]; // Level 0 has none of its own
+    std::atomic<int> pyramidLevels; // Levels built so far; pyramidThread adds them in order
+    std::atomic<bool> pyramidCancelled;
+    std::thread pyramidThread;
+    QList<ImageOperation> operations; // Edits since loading or resetting, in order
+    int resultWidth,resultHeight; // Full size of the edited image
+    bool fitPending; // The edits changed, so the next render fits the result to the window
+    QTimer *renderTimer;
+    QColor backgroundColor; // Fills the corners when the border mode is "Background color"
+    std::thread saveThread;
+    std::atomic<bool> saveCancelled; // Cancel flag of the render being saved, see RotationEngine::setCancelFlag()
+    int saveGeneration; // Counts the saves started or cancelled; saveFinished() only reports the current one
+    bool saving; // saveThread runs; loading is disabled meanwhile, as it would free the image being saved
+
+    void addOperation(ImageOperation::Type type,int degs=0);
+    AffineTransform composeOperations(int &newWidth,int &newHeight,int &degs,bool &flipped) const;
+    static int renderMethod(int method,double scale,int degs);
+    static AffineTransform scalingTransform(double scale);
+    RenderSettings captureSettings() const;
+    uint32_t *renderOperations(const RenderSettings &settings,int &width,int &height,int &stride) const;
+    uint32_t *renderRegion(const RenderSettings &settings,double scale,int x,int y,int width,int height) const;
+    void saveImage(const RenderSettings &settings,const QString &path,int generation);
+    void buildPyramid();
+    void stopPyramid();
+    void fitZoom();
 
 public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
     static uint32_t *qImageToBitmapData(QImage *image);
-    static decimal_t bilinearInterpolate(decimal_t c00, decimal_t c10, decimal_t c01, decimal_t c11, decimal_t w1, decimal_t w2, decimal_t w3, decimal_t w4);
 
 public slots:
     void browseBtnClicked();
@@ -57,7 +111,12 @@ public slots:
     void flipVerticallyBtnClicked();
     void flipHorizontallyBtnClicked();
     void resetBtnClicked();
-    void rotateImage();
+    void renderImage();
+    void renderSettingsChanged();
+    void cropBoxToggled();
+    void backgroundColorBtnClicked();
+    void pyramidLevelBuilt(int level);
+    void saveFinished(int generation,bool saved);
 
 private:
     Ui::MainWindow *ui;
@@ -0,0 +1,1257 @@
+#include "rotationengine.h"
+#include "threadpool.h"
+
+#include <memory>
+
+#if defined(ROTATIONENGINE_X86)&&defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+// sin(0..90 degrees)*2^30, rounded. Used instead of libm so that the fixed-point path is bit-identical everywhere.
+
+static const int32_t fixedSinTable[91]=
+{
+    0,18739379,37473049,56195305,74900443,93582766,
+    112236583,130856211,149435979,167970228,186453311,204879599,
+    223243478,241539355,259761657,277904834,295963357,313931728,
+    331804471,349576144,367241333,384794656,402230767,419544355,
+    436730145,453782903,470697435,487468587,504091252,520560366,
+    536870912,553017922,568996477,584801711,600428808,615873009,
+    631129609,646193961,661061475,675727625,690187940,704438018,
+    718473518,732290163,745883746,759250125,772385229,785285058,
+    797945680,810363241,822533958,834454122,846120104,857528349,
+    868675383,879557810,890172315,900515665,910584710,920376381,
+    929887697,939115760,948057759,956710970,965072759,973140576,
+    980911966,988384560,995556083,1002424350,1008987269,1015242840,
+    1021189159,1026824413,1032146887,1037154959,1041847103,1046221891,
+    1050277989,1054014162,1057429273,1060522280,1063292242,1065738315,
+    1067859754,1069655912,1071126243,1072270298,1073087729,1073578288,
+    1073741824
+};
+
+static int32_t fixedSin30(int degs)
+{
+    degs=RotationEngine::normalizeDegs(degs);
+    if(degs<=90)
+        return fixedSinTable[degs];
+    if(degs<=180)
+        return fixedSinTable[180-degs];
+    if(degs<=270)
+        return -fixedSinTable[degs-180];
+    return -fixedSinTable[360-degs];
+}
+
+// Scales a 2.30 value to 32.32. Negative values are multiplied rather than shifted left, which would be undefined behaviour.
+
+#define FIXED_PER_30 (((fixed_t)1)<<(FIXED_SHIFT-30))
+
+// a*b for a 32.32 value and a 2.30 value, without 128-bit intermediates
+
+static fixed_t fixedMul30(fixed_t a, int32_t b)
+{
+    fixed_t hi=a>>FIXED_SHIFT;
+    fixed_t lo=(fixed_t)(a&0xffffffff);
+    return hi*b*FIXED_PER_30+((lo*b)>>30);
+}
+
+int RotationEngine::normalizeDegs(int degs)
+{
+    if(degs<0)
+        degs=360-(abs(degs)%360);
+    if(degs>=360)
+        degs%=360;
+    return degs;
+}
+
+// Rounds a/b towards negative infinity; b must be positive
+
+static fixed_t floorDiv(fixed_t a, fixed_t b)
+{
+    fixed_t q=a/b;
+    return (a%b!=0&&a<0)?q-1:q;
+}
+
+// Narrows [spanStart,spanEnd) to the pixels i for which lo<=start+i*step<hi; exact in fixed point
+
+static void clipSpan(fixed_t start, fixed_t step, fixed_t lo, fixed_t hi, int &spanStart, int &spanEnd)
+{
+    fixed_t first,end;
+    if(step>0)
+    {
+        first=-floorDiv(start-lo,step);
+        end=-floorDiv(start-hi,step);
+    }
+    else if(step<0)
+    {
+        first=floorDiv(start-hi,-step)+1;
+        end=floorDiv(start-lo,-step)+1;
+    }
+    else
+    {
+        if(start<lo||start>=hi)
+            spanEnd=spanStart;
+        return;
+    }
+    if(first>spanStart)
+        spanStart=first>spanEnd?spanEnd:(int)first;
+    if(end<spanEnd)
+        spanEnd=end<spanStart?spanStart:(int)end;
+}
+
+// Same in double precision; the result may be off by a pixel where start+i*step is within rounding error of a bound
+
+static void clipSpan(decimal_t start, decimal_t step, decimal_t lo, decimal_t hi, int &spanStart, int &spanEnd)
+{
+    decimal_t first,end;
+    if(step>0)
+    {
+        first=ceil((lo-start)/step);
+        end=ceil((hi-start)/step);
+    }
+    else if(step<0)
+    {
+        first=floor((start-hi)/-step)+1;
+        end=floor((start-lo)/-step)+1;
+    }
+    else
+    {
+        if(start<lo||start>=hi)
+            spanEnd=spanStart;
+        return;
+    }
+    if(first>spanStart)
+        spanStart=first>spanEnd?spanEnd:(int)first;
+    if(end<spanEnd)
+        spanEnd=end<spanStart?spanStart:(int)end;
+}
+
+// Double-precision interior kernels and the neighbourhood each method reads, indexed by Method. The fixed-point interior kernels
+// depend on the SIMD level and come from RotationKernels::interiorRows; the checking kernels depend on the border mode.
+
+struct ResampleMethod
+{
+    DoubleRowFunc doubleInteriorRow; // 0 for methods without a double-precision path
+    int before,after; // Neighbours read before and after the pixel at the truncated coordinate
+};
+
+static const ResampleMethod resampleMethods[METHOD_COUNT]=
+{
+    {RotationEngine::doubleNearestNeighborInteriorRow,0,0},
+    {RotationEngine::doubleBilinearInteriorRow,0,1},
+    {0,0,0}, // ThreeShear
+    {0,1,2},
+    {0,2,3}
+};
+
+static inline void fillPixels(uint32_t *out, int count, uint32_t color)
+{
+    for(int i=0;i<count;i++)
+        out[i]=color;
+}
+
+// Each row segment only resamples the span of pixels that map inside the source. The dispatched kernels handle its
+// interior without bounds checks; the few pixels at its ends whose neighbourhood crosses an edge use the checking kernels.
+// With transparent borders, pixels outside the span are never touched: calloc() of a large block maps zeroed pages only once
+// they are written to, which is cheaper than clearing the corners explicitly. Constant borders write them once, as part of the row;
+// the other border modes resample them from the extended source.
+// The guard band of a padded source repeats the edge pixels like the checking kernels of these modes, except for mirrored and wrapped
+// borders; otherwise, every pixel whose rounded coordinate lies inside the source is resampled by the dispatched kernels.
+
+void RotationEngine::resample(const uint32_t *data, int width, int height, uint32_t *newImageData, const FixedRotationGeometry &geometry, int method, int border, uint32_t borderColor)
+{
+    resample(sourceImage(data,width,height),newImageData,geometry,method,border,borderColor);
+}
+
+void RotationEngine::resample(const SourceImage &source, uint32_t *newImageData, const FixedRotationGeometry &geometry, int method, int border, uint32_t borderColor)
+{
+    // The kernels are selected once per call; unknown methods resample using nearest neighbour, unknown border modes are transparent
+
+    if(border<0||border>=BORDER_MODE_COUNT)
+        border=BorderTransparent;
+    if(fixedEdgeRow(method,border)==0)
+        method=NearestNeighbor;
+    ResampleRowFunc interiorRow=kernels().interiorRows[method];
+    ResampleRowFunc edgeRow=fixedEdgeRow(method,border);
+    int before=resampleMethods[method].before;
+    int after=resampleMethods[method].after;
+    bool extendsSource=border!=BorderTransparent&&border!=BorderConstant;
+    bool guarded=source.guardBand>before&&source.guardBand>=after&&border!=BorderMirror&&border!=BorderWrap;
+    const uint32_t *data=source.data;
+    int width=source.width;
+    int height=source.height;
+    int stride=source.stride;
+    fixed_t xStepX=geometry.xStepX;
+    fixed_t xStepY=geometry.xStepY;
+
+    int tileSize=getTileSize(fixedToDecimal(xStepX),fixedToDecimal(xStepY));
+    forEachTileRow(geometry.newWidth,geometry.newHeight,tileSize,[&](int x,int y,int count)
+    {
+        fixed_t origX=geometry.originX+x*xStepX+y*geometry.yStepX;
+        fixed_t origY=geometry.originY+x*xStepY+y*geometry.yStepY;
+        uint32_t *out=newImageData+(size_t)y*geometry.newWidth+x;
+
+        // Pixels whose rounded coordinate exists, or all of them if the source is extended
+
+        int validStart=0,validEnd=count;
+        if(!extendsSource)
+        {
+            clipSpan(origX+FIXED_HALF,xStepX,0,(fixed_t)width<<FIXED_SHIFT,validStart,validEnd);
+            clipSpan(origY+FIXED_HALF,xStepY,0,(fixed_t)height<<FIXED_SHIFT,validStart,validEnd);
+        }
+        if(border==BorderConstant)
+        {
+            fillPixels(out,validStart,borderColor);
+            fillPixels(out+validEnd,count-validEnd,borderColor);
+        }
+
+        // Pixels whose neighbourhood lies inside the source or its guard band: nearest neighbour reads the pixel at the rounded
+        // coordinate, interpolating methods read neighbouring columns and rows as well
+
+        int interiorStart=validStart,interiorEnd=validEnd;
+        if(method==NearestNeighbor||guarded)
+        {
+            clipSpan(origX+FIXED_HALF,xStepX,0,(fixed_t)width<<FIXED_SHIFT,interiorStart,interiorEnd);
+            clipSpan(origY+FIXED_HALF,xStepY,0,(fixed_t)height<<FIXED_SHIFT,interiorStart,interiorEnd);
+        }
+        else
+        {
+            clipSpan(origX,xStepX,before*FIXED_ONE,(width-after)*FIXED_ONE,interiorStart,interiorEnd); // Negative bound for tiny images
+            clipSpan(origY,xStepY,before*FIXED_ONE,(height-after)*FIXED_ONE,interiorStart,interiorEnd);
+        }
+        if(interiorStart==interiorEnd)
+            interiorStart=interiorEnd=validStart;
+
+        edgeRow(data,width,height,stride,out+validStart,interiorStart-validStart,origX+validStart*xStepX,origY+validStart*xStepY,xStepX,xStepY);
+        interiorRow(data,width,height,stride,out+interiorStart,interiorEnd-interiorStart,origX+interiorStart*xStepX,origY+interiorStart*xStepY,xStepX,xStepY);
+        edgeRow(data,width,height,stride,out+interiorEnd,validEnd-interiorEnd,origX+interiorEnd*xStepX,origY+interiorEnd*xStepY,xStepX,xStepY);
+    });
+}
+
+void RotationEngine::resample(const uint32_t *data, int width, int height, uint32_t *newImageData, const RotationGeometry &geometry, int method, int border, uint32_t borderColor)
+{
+    resample(sourceImage(data,width,height),newImageData,geometry,method,border,borderColor);
+}
+
+void RotationEngine::resample(const SourceImage &source, uint32_t *newImageData, const RotationGeometry &geometry, int method, int border, uint32_t borderColor)
+{
+    if(border<0||border>=BORDER_MODE_COUNT)
+        border=BorderTransparent;
+    if(doubleEdgeRow(method,border)==0)
+        method=NearestNeighbor;
+    DoubleRowFunc interiorRow=resampleMethods[method].doubleInteriorRow;
+    DoubleRowFunc edgeRow=doubleEdgeRow(method,border);
+    bool extendsSource=border!=BorderTransparent&&border!=BorderConstant;
+    bool guarded=source.guardBand>resampleMethods[method].before&&source.guardBand>=resampleMethods[method].after&&border!=BorderMirror&&border!=BorderWrap;
+    const uint32_t *data=source.data;
+    int width=source.width;
+    int height=source.height;
+    int stride=source.stride;
+    decimal_t xStepX=geometry.xStepX;
+    decimal_t xStepY=geometry.xStepY;
+
+    // The source coordinate of each destination pixel is evaluated from the start of its whole row, which only depends on the row.
+    // Stepping it from the start of the tile would round differently for every tile size, and for every window of the destination.
+
+    int tileSize=getTileSize(xStepX,xStepY);
+    forEachTileRow(geometry.newWidth,geometry.newHeight,tileSize,[&](int x,int y,int count)
+    {
+        decimal_t rowX=geometry.originX+(geometry.top+y)*geometry.yStepX;
+        decimal_t rowY=geometry.originY+(geometry.top+y)*geometry.yStepY;
+        int first=geometry.left+x;
+        decimal_t origX=rowX+first*xStepX;
+        decimal_t origY=rowY+first*xStepY;
+        uint32_t *out=newImageData+(size_t)y*geometry.newWidth+x;
+
+        // Pixels that may map inside the source (their rounded coordinate exists, give or take SPAN_MARGIN), or all of them if the
+        // source is extended
+
+        int outerStart=0,outerEnd=count;
+        if(!extendsSource)
+        {
+            clipSpan(origX,xStepX,-0.5-SPAN_MARGIN,width-0.5+SPAN_MARGIN,outerStart,outerEnd);
+            clipSpan(origY,xStepY,-0.5-SPAN_MARGIN,height-0.5+SPAN_MARGIN,outerStart,outerEnd);
+        }
+
+        // Pixels that certainly do, with all neighbours the method reads inside the source or its guard band
+
+        int interiorStart=outerStart,interiorEnd=outerEnd;
+        if(method==Bilinear&&!guarded)
+        {
+            clipSpan(origX,xStepX,SPAN_MARGIN,width-1-SPAN_MARGIN,interiorStart,interiorEnd);
+            clipSpan(origY,xStepY,SPAN_MARGIN,height-1-SPAN_MARGIN,interiorStart,interiorEnd);
+        }
+        else
+        {
+            clipSpan(origX,xStepX,-0.5+SPAN_MARGIN,width-0.5-SPAN_MARGIN,interiorStart,interiorEnd);
+            clipSpan(origY,xStepY,-0.5+SPAN_MARGIN,height-0.5-SPAN_MARGIN,interiorStart,interiorEnd);
+        }
+        if(interiorStart==interiorEnd)
+            interiorStart=interiorEnd=outerStart;
+
+        // The checking kernels skip the pixels near the ends of the outer span that do not map inside after all,
+        // so those get the border colour beforehand
+
+        if(border==BorderConstant)
+        {
+            fillPixels(out,interiorStart,borderColor);
+            fillPixels(out+interiorEnd,count-interiorEnd,borderColor);
+        }
+
+        // Both kinds of kernels evaluate a pixel's coordinate the same way, so the result does not depend on the spans
+
+        edgeRow(data,width,height,stride,out+outerStart,first+outerStart,interiorStart-outerStart,rowX,rowY,xStepX,xStepY);
+        interiorRow(data,width,height,stride,out+interiorStart,first+interiorStart,interiorEnd-interiorStart,rowX,rowY,xStepX,xStepY);
+        edgeRow(data,width,height,stride,out+interiorEnd,first+interiorEnd,outerEnd-interiorEnd,rowX,rowY,xStepX,xStepY);
+    });
+}
+
+SourceImage RotationEngine::sourceImage(const uint32_t *data, int width, int height)
+{
+    SourceImage image;
+    image.data=data;
+    image.width=width;
+    image.height=height;
+    image.stride=width;
+    image.guardBand=0;
+    return image;
+}
+
+// Allocates a padded width*height image and describes it in "image". malloc() only guarantees a small alignment, so the buffer has
+// PADDED_STRIDE_ALIGNMENT spare pixels to move pixel (0,0), and with it the first pixel of every row, onto a boundary of that many
+// pixels. "padded" receives the first pixel of the top guard band row. Returns the buffer for free().
+
+static uint32_t *allocatePadded(int width, int height, SourceImage &image, uint32_t *&padded)
+{
+    const uintptr_t alignment=PADDED_STRIDE_ALIGNMENT*sizeof(uint32_t);
+    int stride=(width+2*GUARD_BAND+PADDED_STRIDE_ALIGNMENT-1)/PADDED_STRIDE_ALIGNMENT*PADDED_STRIDE_ALIGNMENT;
+    uint32_t *buffer=(uint32_t*)malloc(((size_t)stride*(height+2*GUARD_BAND)+PADDED_STRIDE_ALIGNMENT)*sizeof(uint32_t));
+    uintptr_t first=(uintptr_t)(buffer+(size_t)GUARD_BAND*stride+GUARD_BAND);
+    uint32_t *data=(uint32_t*)((first+alignment-1)&~(alignment-1));
+    padded=data-(size_t)GUARD_BAND*stride-GUARD_BAND;
+
+    image.data=data;
+    image.width=width;
+    image.height=height;
+    image.stride=stride;
+    image.guardBand=GUARD_BAND;
+    return buffer;
+}
+
+uint32_t *RotationEngine::padImage(const uint32_t *data, int width, int height, SourceImage &image)
+{
+    // The band is filled once, when the image is loaded, instead of clamping neighbour coordinates for every destination pixel.
+    // Columns beyond the right guard band only align the rows and are zeroed.
+
+    uint32_t *padded;
+    uint32_t *buffer=allocatePadded(width,height,image,padded);
+    int stride=image.stride;
+    parallelRows(height+2*GUARD_BAND,[&](int yStart,int yEnd)
+    {
+        for(int y=yStart;y<yEnd;y++)
+        {
+            const uint32_t *in=data+(size_t)__max(__min(y-GUARD_BAND,height-1),0)*width;
+            uint32_t *out=padded+(size_t)y*stride;
+            fillPixels(out,GUARD_BAND,in[0]);
+            memcpy(out+GUARD_BAND,in,width*sizeof(uint32_t));
+            fillPixels(out+GUARD_BAND+width,GUARD_BAND,in[width-1]);
+            memset(out+width+2*GUARD_BAND,0,(stride-width-2*GUARD_BAND)*sizeof(uint32_t));
+        }
+    });
+    return buffer;
+}
+
+uint32_t *RotationEngine::halveImage(const SourceImage &source, SourceImage &image)
+{
+    // Each pixel averages a 2x2 block. With an odd size, the last block reaches into the guard band, i.e. repeats the edge pixels.
+    // Premultiplied channels average independently: a colour channel cannot exceed alpha in the sum of four, so neither in the result.
+
+    int width=(source.width+1)/2;
+    int height=(source.height+1)/2;
+    uint32_t *padded;
+    uint32_t *buffer=allocatePadded(width,height,image,padded);
+    uint32_t *data=(uint32_t*)image.data;
+    int stride=image.stride;
+    parallelRows(height,[&](int yStart,int yEnd)
+    {
+        for(int y=yStart;y<yEnd;y++)
+        {
+            uint32_t *out=data+(size_t)y*stride;
+            halveRow(source.data+(size_t)2*y*source.stride,source.stride,out,width);
+            fillPixels(out-GUARD_BAND,GUARD_BAND,out[0]);
+            fillPixels(out+width,GUARD_BAND,out[width-1]);
+            memset(out+width+GUARD_BAND,0,(stride-width-2*GUARD_BAND)*sizeof(uint32_t));
+        }
+    });
+    for(int y=0;y<GUARD_BAND;y++)
+    {
+        memcpy(padded+(size_t)y*stride,padded+(size_t)GUARD_BAND*stride,stride*sizeof(uint32_t));
+        memcpy(padded+(size_t)(height+GUARD_BAND+y)*stride,padded+(size_t)(height+GUARD_BAND-1)*stride,stride*sizeof(uint32_t));
+    }
+    return buffer;
+}
+
+// Destination buffer for resample(); only transparent borders leave pixels unwritten, so other modes skip zeroing it
+
+static uint32_t *allocateDestination(int newWidth, int newHeight, int border)
+{
+    if(border==RotationEngine::BorderTransparent)
+        return (uint32_t*)calloc((size_t)newWidth*newHeight,sizeof(uint32_t));
+    return (uint32_t*)malloc((size_t)newWidth*newHeight*sizeof(uint32_t));
+}
+
+uint32_t *RotationEngine::rotate(const uint32_t *data, int width, int height, int degs, int method, int precision, int &newWidth, int &newHeight, int border, uint32_t borderColor)
+{
+    degs=normalizeDegs(degs);
+    if(border<0||border>=BORDER_MODE_COUNT)
+        border=BorderTransparent;
+
+    uint32_t *newImageData;
+
+    // Every transformation below is split into bands of destination rows, which are processed by the thread pool.
+    // Rows do not depend on each other, so the result is identical for any number of threads.
+
+    if(degs%90==0)
+    {
+        const RotationKernels &k=kernels();
+        TransformRowsFunc transformRows;
+        if(degs==0)
+        {
+            newWidth=width;
+            newHeight=height;
+            size_t imageDataSize=newWidth*newHeight*sizeof(uint32_t);
+            newImageData=(uint32_t*)malloc(imageDataSize);
+            memcpy(newImageData,data,imageDataSize);
+            return newImageData;
+        }
+        else if(degs==90)
+        {
+            newWidth=height;
+            newHeight=width;
+            transformRows=k.rotate90;
+        }
+        else if(degs==180)
+        {
+            newWidth=width;
+            newHeight=height;
+            transformRows=k.rotate180;
+        }
+        else // 270
+        {
+            newWidth=height;
+            newHeight=width;
+            transformRows=k.rotate270;
+        }
+        newImageData=(uint32_t*)malloc(newWidth*newHeight*sizeof(uint32_t));
+        parallelRows(newHeight,[&](int yStart,int yEnd)
+        {
+            transformRows(data,width,height,newImageData,yStart,yEnd);
+        });
+        return newImageData;
+    }
+
+    // The shears pad with transparent pixels between passes, so other border modes resample bilinearly
+
+    if(method==ThreeShear&&border==BorderTransparent)
+        return rotateThreeShear(data,width,height,degs,newWidth,newHeight);
+    if(method==ThreeShear)
+        method=Bilinear;
+
+    if(precision==FixedPoint||method==Bicubic||method==Lanczos3)
+    {
+        FixedRotationGeometry geometry=getFixedRotationGeometry(width,height,degs);
+        newWidth=geometry.newWidth;
+        newHeight=geometry.newHeight;
+        newImageData=allocateDestination(newWidth,newHeight,border);
+        resample(data,width,height,newImageData,geometry,method,border,borderColor);
+        return newImageData;
+    }
+
+    RotationGeometry geometry=getRotationGeometry(width,height,degs);
+    newWidth=geometry.newWidth;
+    newHeight=geometry.newHeight;
+    newImageData=allocateDestination(newWidth,newHeight,border);
+    resample(data,width,height,newImageData,geometry,method,border,borderColor);
+    return newImageData;
+}
+
+uint32_t *RotationEngine::transform(const uint32_t *data, int width, int height, const AffineTransform &matrix, int newWidth, int newHeight, int method, int precision, int border, uint32_t borderColor)
+{
+    return transform(sourceImage(data,width,height),matrix,newWidth,newHeight,method,precision,border,borderColor);
+}
+
+uint32_t *RotationEngine::transform(const SourceImage &source, const AffineTransform &matrix, int newWidth, int newHeight, int method, int precision, int border, uint32_t borderColor)
+{
+    // One resampling pass and one allocation, whatever the matrix combines. The destination is sampled through the inverse
+    // mapping, exactly as for rotations.
+
+    decimal_t determinant=matrix.m11*matrix.m22-matrix.m12*matrix.m21;
+    if(determinant==0.0||newWidth<=0||newHeight<=0)
+        return 0;
+
+    RotationGeometry geometry;
+    geometry.newWidth=newWidth;
+    geometry.newHeight=newHeight;
+    geometry.left=0;
+    geometry.top=0;
+    geometry.xStepX=matrix.m22/determinant;
+    geometry.xStepY=-matrix.m21/determinant;
+    geometry.yStepX=-matrix.m12/determinant;
+    geometry.yStepY=matrix.m11/determinant;
+    geometry.originX=-(geometry.xStepX*matrix.dx+geometry.yStepX*matrix.dy);
+    geometry.originY=-(geometry.xStepY*matrix.dx+geometry.yStepY*matrix.dy);
+
+    // Shears only decompose pure rotations
+
+    if(method==ThreeShear)
+        method=Bilinear;
+    if(border<0||border>=BORDER_MODE_COUNT)
+        border=BorderTransparent;
+
+    uint32_t *newImageData=allocateDestination(newWidth,newHeight,border);
+    if(precision==FixedPoint||method==Bicubic||method==Lanczos3)
+    {
+        FixedRotationGeometry fixedGeometry;
+        fixedGeometry.newWidth=newWidth;
+        fixedGeometry.newHeight=newHeight;
+        fixedGeometry.originX=decimalToFixed(geometry.originX);
+        fixedGeometry.originY=decimalToFixed(geometry.originY);
+        fixedGeometry.xStepX=decimalToFixed(geometry.xStepX);
+        fixedGeometry.xStepY=decimalToFixed(geometry.xStepY);
+        fixedGeometry.yStepX=decimalToFixed(geometry.yStepX);
+        fixedGeometry.yStepY=decimalToFixed(geometry.yStepY);
+        resample(source,newImageData,fixedGeometry,method,border,borderColor);
+    }
+    else
+        resample(source,newImageData,geometry,method,border,borderColor);
+    return newImageData;
+}
+
+// Geometry of the newWidth*newHeight window at (x,y) of a destination. Fixed-point origins move exactly; double-precision ones stay
+// where they are, so that the window samples the same coordinates as the whole destination.
+
+static FixedRotationGeometry cropGeometry(FixedRotationGeometry geometry, int x, int y, int newWidth, int newHeight)
+{
+    geometry.newWidth=newWidth;
+    geometry.newHeight=newHeight;
+    geometry.originX+=x*geometry.xStepX+y*geometry.yStepX;
+    geometry.originY+=x*geometry.xStepY+y*geometry.yStepY;
+    return geometry;
+}
+
+static RotationGeometry cropGeometry(RotationGeometry geometry, int x, int y, int newWidth, int newHeight)
+{
+    geometry.newWidth=newWidth;
+    geometry.newHeight=newHeight;
+    geometry.left+=x;
+    geometry.top+=y;
+    return geometry;
+}
+
+uint32_t *RotationEngine::rotateCropped(const uint32_t *data, int width, int height, int degs, int method, int precision, int &newWidth, int &newHeight)
+{
+    degs=normalizeDegs(degs);
+    if(degs%90==0)
+        return rotate(data,width,height,degs,method,precision,newWidth,newHeight);
+    if(method==ThreeShear)
+        method=Bilinear;
+
+    // Every pixel of the rectangle maps inside the source. Clamped borders write all of them without a zeroed buffer,
+    // and their neighbours beyond the edges are the same as with transparent borders.
+
+    int x,y;
+    getInscribedRectangle(width,height,degs,x,y,newWidth,newHeight);
+    return rotateRegion(data,width,height,degs,method,precision,x,y,newWidth,newHeight,BorderClamp);
+}
+
+uint32_t *RotationEngine::rotateRegion(const uint32_t *data, int width, int height, int degs, int method, int precision, int x, int y, int regionWidth, int regionHeight, int border, uint32_t borderColor)
+{
+    if(regionWidth<=0||regionHeight<=0)
+        return 0;
+    degs=normalizeDegs(degs);
+    if(border<0||border>=BORDER_MODE_COUNT)
+        border=BorderTransparent;
+    if(degs%90==0)
+    {
+        method=NearestNeighbor;
+        precision=FixedPoint;
+    }
+    else if(method==ThreeShear)
+        method=Bilinear;
+
+    uint32_t *newImageData=allocateDestination(regionWidth,regionHeight,border);
+    if(precision==FixedPoint||method==Bicubic||method==Lanczos3)
+        resample(data,width,height,newImageData,cropGeometry(getFixedRotationGeometry(width,height,degs),x,y,regionWidth,regionHeight),method,border,borderColor);
+    else
+        resample(data,width,height,newImageData,cropGeometry(getRotationGeometry(width,height,degs),x,y,regionWidth,regionHeight),method,border,borderColor);
+    return newImageData;
+}
+
+void RotationEngine::getInscribedRectangle(int width, int height, int degs, int &x, int &y, int &cropWidth, int &cropHeight)
+{
+    degs=normalizeDegs(degs);
+    decimal_t c=fabs(fixedSin30(degs+90)/(decimal_t)(1<<30));
+    decimal_t s=fabs(fixedSin30(degs)/(decimal_t)(1<<30));
+
+    // The source covers width*height pixels around its center, which the destination places at half the extent of the pixel centers
+
+    decimal_t centerX=((width-1)*c+(height-1)*s)*0.5;
+    decimal_t centerY=((width-1)*s+(height-1)*c)*0.5;
+
+    // Largest rectangle inside the rotated source. If the short side is small compared to the long one, two of its corners touch
+    // the long sides only, and it is half as long as the short side in the direction across them; otherwise all four corners touch.
+
+    decimal_t longSide=__max(width,height);
+    decimal_t shortSide=__min(width,height);
+    decimal_t insideWidth,insideHeight;
+    if(shortSide<=2.0*s*c*longSide||fabs(s-c)<1e-10)
+    {
+        decimal_t half=0.5*shortSide;
+        insideWidth=width>=height?half/s:half/c;
+        insideHeight=width>=height?half/c:half/s;
+    }
+    else
+    {
+        decimal_t cos2=c*c-s*s;
+        insideWidth=(width*c-height*s)/cos2;
+        insideHeight=(height*c-width*s)/cos2;
+    }
+
+    // Destination pixels whose whole area lies inside; the center pixel at least, which maps onto the center of the source
+
+    FixedRotationGeometry geometry=getFixedRotationGeometry(width,height,degs);
+    x=__max((int)ceil(centerX-insideWidth*0.5+0.5),0);
+    y=__max((int)ceil(centerY-insideHeight*0.5+0.5),0);
+    cropWidth=__min((int)floor(centerX+insideWidth*0.5-0.5)+1,geometry.newWidth)-x;
+    cropHeight=__min((int)floor(centerY+insideHeight*0.5-0.5)+1,geometry.newHeight)-y;
+    if(cropWidth<1)
+    {
+        x=(int)floor(centerX+0.5);
+        cropWidth=1;
+    }
+    if(cropHeight<1)
+    {
+        y=(int)floor(centerY+0.5);
+        cropHeight=1;
+    }
+}
+
+AffineTransform RotationEngine::rotationTransform(int width, int height, int degs, int &newWidth, int &newHeight)
+{
+    degs=normalizeDegs(degs);
+    AffineTransform matrix;
+
+    // Quarter turns are built exactly, so that they map pixel centers onto pixel centers like the lossless kernels
+
+    if(degs%90==0)
+    {
+        int c=degs==0?1:(degs==180?-1:0);
+        int s=degs==90?1:(degs==270?-1:0);
+        newWidth=s!=0?height:width;
+        newHeight=s!=0?width:height;
+        matrix.m11=c;
+        matrix.m12=-s;
+        matrix.m21=s;
+        matrix.m22=c;
+        matrix.dx=(c<0?width-1:0)+(s>0?height-1:0);
+        matrix.dy=(c<0?height-1:0)+(s<0?width-1:0);
+        return matrix;
+    }
+
+    // Otherwise the inverse of the mapping getRotationGeometry() samples with
+
+    RotationGeometry geometry=getRotationGeometry(width,height,degs);
+    newWidth=geometry.newWidth;
+    newHeight=geometry.newHeight;
+    decimal_t determinant=geometry.xStepX*geometry.yStepY-geometry.yStepX*geometry.xStepY;
+    matrix.m11=geometry.yStepY/determinant;
+    matrix.m12=-geometry.yStepX/determinant;
+    matrix.m21=-geometry.xStepY/determinant;
+    matrix.m22=geometry.xStepX/determinant;
+    matrix.dx=-(matrix.m11*geometry.originX+matrix.m12*geometry.originY);
+    matrix.dy=-(matrix.m21*geometry.originX+matrix.m22*geometry.originY);
+    return matrix;
+}
+
+AffineTransform RotationEngine::combineTransforms(const AffineTransform &first, const AffineTransform &second)
+{
+    AffineTransform matrix;
+    matrix.m11=second.m11*first.m11+second.m12*first.m21;
+    matrix.m12=second.m11*first.m12+second.m12*first.m22;
+    matrix.dx=second.m11*first.dx+second.m12*first.dy+second.dx;
+    matrix.m21=second.m21*first.m11+second.m22*first.m21;
+    matrix.m22=second.m21*first.m12+second.m22*first.m22;
+    matrix.dy=second.m21*first.dx+second.m22*first.dy+second.dy;
+    return matrix;
+}
+
+// Shifts a row by "shift" pixels with linear interpolation: out[x] is "in" sampled at x+shift.
+// Pixels beyond either end of "in" count as transparent.
+
+static void shiftRow(ShearRowFunc blendRow, const uint32_t *in, int inWidth, uint32_t *out, int outWidth, fixed_t shift)
+{
+    int offset=fixedToInt(shift);
+    uint32_t weight=bilinearWeight(shift);
+
+    // out[x] blends in[x+offset] and in[x+offset+1]. Both exist in [interiorStart,interiorEnd); neither exists outside [edgeStart,edgeEnd).
+
+    int edgeStart=__max(__min(-offset-1,outWidth),0);
+    int edgeEnd=__max(__min(inWidth-offset,outWidth),edgeStart);
+    int interiorStart=__max(__min(-offset,edgeEnd),edgeStart);
+    int interiorEnd=__max(__min(inWidth-1-offset,edgeEnd),interiorStart);
+
+    auto edgePixel=[&](int x)
+    {
+        int i=x+offset;
+        uint32_t pair[2]={i>=0?in[i]:0,i+1<inWidth?in[i+1]:0};
+        RotationEngine::shearRow(pair,out+x,1,weight);
+    };
+
+    memset(out,0,edgeStart*sizeof(uint32_t));
+    for(int x=edgeStart;x<interiorStart;x++)
+        edgePixel(x);
+    blendRow(in+interiorStart+offset,out+interiorStart,interiorEnd-interiorStart,weight);
+    for(int x=interiorEnd;x<edgeEnd;x++)
+        edgePixel(x);
+    memset(out+edgeEnd,0,(outWidth-edgeEnd)*sizeof(uint32_t));
+}
+
+uint32_t *RotationEngine::rotateThreeShear(const uint32_t *data, int width, int height, int degs, int &newWidth, int &newHeight)
+{
+    // Every pass shifts whole rows or columns by a constant amount, so it streams through memory without 2D gathers
+
+    degs=normalizeDegs(degs);
+    if(degs%90==0)
+        return rotate(data,width,height,degs,NearestNeighbor,FixedPoint,newWidth,newHeight);
+
+    // The output has the same size as with the other methods
+
+    FixedRotationGeometry geometry=getFixedRotationGeometry(width,height,degs);
+    newWidth=geometry.newWidth;
+    newHeight=geometry.newHeight;
+
+    // Shears beyond 45 degrees would stretch the intermediate images a lot, so the nearest multiple of 90 degrees is applied exactly first
+
+    int quarterDegs=((degs+45)/90)*90;
+    int residualDegs=degs-quarterDegs;
+    const uint32_t *source=data;
+    uint32_t *rotatedSource=0;
+    int sourceWidth=width;
+    int sourceHeight=height;
+    if(normalizeDegs(quarterDegs)!=0)
+    {
+        rotatedSource=rotate(data,width,height,quarterDegs,NearestNeighbor,FixedPoint,sourceWidth,sourceHeight);
+        source=rotatedSource;
+    }
+
+    // Relative to the centers, a destination pixel maps to the source by Sx(a)*Sy(b)*Sx(a),
+    // where Sx(a) maps (x,y) to (x+a*y,y) and Sy(b) maps (x,y) to (x,b*x+y), with a=tan(degs/2) and b=-sin(degs).
+
+    decimal_t c=fixedSin30(residualDegs+90)/(decimal_t)(1<<30);
+    decimal_t s=fixedSin30(residualDegs)/(decimal_t)(1<<30);
+    decimal_t a=(1.0-c)/s;
+    decimal_t b=-s;
+    decimal_t sourceCenterX=(sourceWidth-1)*0.5;
+    decimal_t sourceCenterY=(sourceHeight-1)*0.5;
+    decimal_t centerX=(newWidth-1)*0.5;
+    decimal_t centerY=(newHeight-1)*0.5;
+
+    // Columns of the intermediate images span x+a*y over the destination, plus a pixel for interpolation
+
+    decimal_t reach=centerX+fabs(a)*centerY;
+    int firstColumn=(int)floor(-reach)-1;
+    int columns=(int)ceil(reach)+2-firstColumn;
+
+    ShearRowFunc blendRow=kernels().shearRow;
+    TransposeFunc transpose=kernels().transpose;
+
+    // The first horizontal shear and the vertical shear are done together in strips of columns, so that the vertical shear
+    // works on contiguous columns in a small buffer instead of transposing the whole intermediate image twice
+
+    uint32_t *sheared=(uint32_t*)malloc((size_t)columns*newHeight*sizeof(uint32_t));
+    int strips=(columns+SHEAR_STRIP_WIDTH-1)/SHEAR_STRIP_WIDTH;
+    parallelFor(strips,1,[&](int stripStart,int stripEnd)
+    {
+        uint32_t *sourceColumns=(uint32_t*)malloc((size_t)SHEAR_STRIP_WIDTH*sourceHeight*sizeof(uint32_t));
+        uint32_t *shearedColumns=(uint32_t*)malloc((size_t)SHEAR_STRIP_WIDTH*newHeight*sizeof(uint32_t));
+        for(int strip=stripStart;strip<stripEnd;strip++)
+        {
+            int xStart=strip*SHEAR_STRIP_WIDTH;
+            int stripWidth=__min(SHEAR_STRIP_WIDTH,columns-xStart);
+
+            // Columns of the horizontally sheared source, stored one after another. Segments of a few rows are sheared
+            // into a buffer that stays in registers and L1, then transposed into the columns in blocks.
+
+            uint32_t segments[SHEAR_BLOCK_ROWS*SHEAR_STRIP_WIDTH];
+            for(int yBlock=0;yBlock<sourceHeight;yBlock+=SHEAR_BLOCK_ROWS)
+            {
+                int blockRows=__min(SHEAR_BLOCK_ROWS,sourceHeight-yBlock);
+                for(int j=0;j<blockRows;j++)
+                {
+                    int y=yBlock+j;
+                    shiftRow(blendRow,source+(size_t)y*sourceWidth,sourceWidth,segments+j*SHEAR_STRIP_WIDTH,stripWidth,decimalToFixed(xStart+firstColumn+sourceCenterX+a*(y-sourceCenterY)));
+                }
+                transpose(segments,SHEAR_STRIP_WIDTH,sourceColumns+yBlock,sourceHeight,stripWidth,blockRows);
+            }
+
+            for(int x=0;x<stripWidth;x++)
+            {
+                decimal_t columnShift=b*(xStart+x+firstColumn)+sourceCenterY-centerY;
+                shiftRow(blendRow,sourceColumns+(size_t)x*sourceHeight,sourceHeight,shearedColumns+(size_t)x*newHeight,newHeight,decimalToFixed(columnShift));
+            }
+
+            transpose(shearedColumns,newHeight,sheared+xStart,columns,newHeight,stripWidth);
+        }
+        free(sourceColumns);
+        free(shearedColumns);
+    });
+    free(rotatedSource);
+
+    // Second horizontal shear: destination rows
+
+    uint32_t *newImageData=(uint32_t*)malloc((size_t)newWidth*newHeight*sizeof(uint32_t));
+    parallelRows(newHeight,[&](int yStart,int yEnd)
+    {
+        for(int y=yStart;y<yEnd;y++)
+            shiftRow(blendRow,sheared+(size_t)y*columns,columns,newImageData+(size_t)y*newWidth,newWidth,decimalToFixed(-centerX-firstColumn+a*(y-centerY)));
+    });
+    free(sheared);
+    return newImageData;
+}
+
+RotationGeometry RotationEngine::getRotationGeometry(int width, int height, int degs)
+{
+    decimal_t degsToRotate=(((decimal_t)normalizeDegs(degs))/180.0f)*M_PI;
+
+    decimal_t rightmostPossibleX=width-1;
+    decimal_t bottommostPossibleY=height-1;
+
+    // Both images share the same center
+
+    decimal_t centerX=rightmostPossibleX*0.5;
+    decimal_t centerY=bottommostPossibleY*0.5;
+
+    // Calculate new edge points' positions and extract image size from them
+
+    // These edge distances stay the same as the image is rotated
+
+    decimal_t dTopLeftEdge=sqrt(pow2(centerX)+pow2(centerY));
+    decimal_t dTopRightEdge=sqrt(pow2(centerX-rightmostPossibleX)+pow2(centerY));
+    decimal_t dBottomLeftEdge=sqrt(pow2(centerX)+pow2(centerY-bottommostPossibleY));
+    decimal_t dBottomRightEdge=sqrt(pow2(centerX-rightmostPossibleX)+pow2(centerY-bottommostPossibleY));
+
+    // Calculate the new positions of these points (needed to determine the new image's dimensions)
+
+    decimal_t topLeftAngle=atan(decimalDiv(centerY,centerX));
+    decimal_t topLeftX=(centerX-cos(topLeftAngle+degsToRotate)*dTopLeftEdge);
+    decimal_t topLeftY=(centerY-sin(topLeftAngle+degsToRotate)*dTopLeftEdge);
+
+    decimal_t topRightAngle=atan(decimalDiv(rightmostPossibleX-centerX,centerY));
+    decimal_t topRightX=(centerX+sin(topRightAngle+degsToRotate)*dTopRightEdge);
+    decimal_t topRightY=(centerY-cos(topRightAngle+degsToRotate)*dTopRightEdge);
+
+    decimal_t bottomLeftAngle=atan(decimalDiv(centerX,bottommostPossibleY-centerY));
+    decimal_t bottomLeftX=(centerX-sin(bottomLeftAngle+degsToRotate)*dBottomLeftEdge);
+    decimal_t bottomLeftY=(centerY+cos(bottomLeftAngle+degsToRotate)*dBottomLeftEdge);
+
+    decimal_t bottomRightAngle=atan(decimalDiv(bottommostPossibleY-centerY,rightmostPossibleX-centerX));
+    decimal_t bottomRightX=(centerX+cos(bottomRightAngle+degsToRotate)*dBottomRightEdge);
+    decimal_t bottomRightY=(centerY+sin(bottomRightAngle+degsToRotate)*dBottomRightEdge);
+
+    decimal_t leftmostX=(__min(topLeftX,__min(topRightX,__min(bottomLeftX,bottomRightX))));
+    decimal_t topmostY=(__min(topLeftY,__min(topRightY,__min(bottomLeftY,bottomRightY))));
+    decimal_t rightmostX=(__max(topLeftX,__max(topRightX,__max(bottomLeftX,bottomRightX))));
+    decimal_t bottommostY=(__max(topLeftY,__max(topRightY,__max(bottomLeftY,bottomRightY))));
+
+    RotationGeometry geometry;
+
+    // This is calculated correctly:
+
+    geometry.newWidth=ceil(rightmostX-leftmostX);
+    geometry.newHeight=ceil(bottommostY-topmostY);
+    geometry.left=0;
+    geometry.top=0;
+
+    // A destination point (dX,dY) keeps its distance to the center and is rotated back by degsToRotate:
+    // orig=center-R(-degsToRotate)*(center-d). This is affine in (x,y), so it can be expressed as an origin plus two steps.
+
+    decimal_t c=cos(degsToRotate);
+    decimal_t s=sin(degsToRotate);
+    decimal_t u=centerX-leftmostX; // centerX-dX at x=0
+    decimal_t v=centerY-topmostY; // centerY-dY at y=0
+
+    geometry.originX=centerX-(u*c+v*s);
+    geometry.originY=centerY-(v*c-u*s);
+    geometry.xStepX=c;
+    geometry.xStepY=-s;
+    geometry.yStepX=s;
+    geometry.yStepY=c;
+    return geometry;
+}
+
+FixedRotationGeometry RotationEngine::getFixedRotationGeometry(int width, int height, int degs)
+{
+    // Same mapping as getRotationGeometry(), derived with integer arithmetic only
+
+    fixed_t c=fixedSin30(degs+90)*FIXED_PER_30;
+    fixed_t s=fixedSin30(degs)*FIXED_PER_30;
+    fixed_t absC=c<0?-c:c;
+    fixed_t absS=s<0?-s:s;
+
+    // Size of the rotated bounding box
+
+    fixed_t extentX=(width-1)*absC+(height-1)*absS;
+    fixed_t extentY=(width-1)*absS+(height-1)*absC;
+
+    FixedRotationGeometry geometry;
+    geometry.newWidth=fixedToInt(extentX+FIXED_ONE-1);
+    geometry.newHeight=fixedToInt(extentY+FIXED_ONE-1);
+
+    fixed_t centerX=((fixed_t)(width-1))<<(FIXED_SHIFT-1);
+    fixed_t centerY=((fixed_t)(height-1))<<(FIXED_SHIFT-1);
+    fixed_t u=extentX/2; // centerX-dX at x=0
+    fixed_t v=extentY/2; // centerY-dY at y=0
+    int32_t c30=fixedSin30(degs+90);
+    int32_t s30=fixedSin30(degs);
+
+    geometry.originX=centerX-(fixedMul30(u,c30)+fixedMul30(v,s30));
+    geometry.originY=centerY-(fixedMul30(v,c30)-fixedMul30(u,s30));
+    geometry.xStepX=c;
+    geometry.xStepY=-s;
+    geometry.yStepX=s;
+    geometry.yStepY=c;
+    return geometry;
+}
+
+uint32_t *RotationEngine::flipVertically(const uint32_t *data, int width, int height)
+{
+    uint32_t *newImageData=(uint32_t*)malloc(width*height*sizeof(uint32_t));
+    TransformRowsFunc flipRows=kernels().flipVertically;
+    parallelRows(height,[&](int yStart,int yEnd)
+    {
+        flipRows(data,width,height,newImageData,yStart,yEnd);
+    });
+    return newImageData;
+}
+
+uint32_t *RotationEngine::flipHorizontally(const uint32_t *data, int width, int height)
+{
+    uint32_t *newImageData=(uint32_t*)malloc(width*height*sizeof(uint32_t));
+    TransformRowsFunc flipRows=kernels().flipHorizontally;
+    parallelRows(height,[&](int yStart,int yEnd)
+    {
+        flipRows(data,width,height,newImageData,yStart,yEnd);
+    });
+    return newImageData;
+}
+
+void RotationEngine::rotate180InPlace(uint32_t *data, int width, int height)
+{
+    // Row pairs are split among threads; the middle row of an odd height is its own pair
+
+    InPlaceRowsFunc transformRows=kernels().rotate180InPlace;
+    parallelRows((height+1)/2,[&](int yStart,int yEnd)
+    {
+        transformRows(data,width,height,yStart,yEnd);
+    });
+}
+
+void RotationEngine::flipVerticallyInPlace(uint32_t *data, int width, int height)
+{
+    InPlaceRowsFunc transformRows=kernels().flipVerticallyInPlace;
+    parallelRows(height/2,[&](int yStart,int yEnd)
+    {
+        transformRows(data,width,height,yStart,yEnd);
+    });
+}
+
+void RotationEngine::flipHorizontallyInPlace(uint32_t *data, int width, int height)
+{
+    InPlaceRowsFunc transformRows=kernels().flipHorizontallyInPlace;
+    parallelRows(height,[&](int yStart,int yEnd)
+    {
+        transformRows(data,width,height,yStart,yEnd);
+    });
+}
+
+uint32_t *RotationEngine::bitmapDataFromScanLines(const uint8_t *bits, int bytesPerLine, int width, int height)
+{
+    // Expects 32-bit scan lines in the native 0xAARRGGBB layout with premultiplied alpha (QImage::Format_ARGB32_Premultiplied and equivalent)
+
+    uint32_t *out=(uint32_t*)malloc(width*height*sizeof(uint32_t));
+    ConvertRowsFunc convertRows=kernels().convertScanLines;
+    parallelRows(height,[&](int yStart,int yEnd)
+    {
+        convertRows(bits,bytesPerLine,width,out,yStart,yEnd);
+    });
+    return out;
+}
+
+decimal_t RotationEngine::bilinearInterpolate(decimal_t c00, decimal_t c10, decimal_t c01, decimal_t c11, decimal_t w1, decimal_t w2, decimal_t w3, decimal_t w4)
+{
+    return w1*c00+w2*c01+w3*c10+w4*c11;
+}
+
+int RotationEngine::detectSimdLevel()
+{
+#ifdef ROTATIONENGINE_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info,0);
+    int maxLeaf=info[0];
+    __cpuid(info,1);
+    if(!(info[2]&(1<<20))) // SSE4.2
+        return SimdScalar;
+    if(maxLeaf<7||!(info[2]&(1<<27))||!(info[2]&(1<<28))) // OSXSAVE, AVX
+        return SimdSse42;
+    unsigned long long xcr0=_xgetbv(0);
+    if((xcr0&6)!=6) // XMM and YMM state enabled by the OS
+        return SimdSse42;
+    __cpuidex(info,7,0);
+    if(!(info[1]&(1<<5))) // AVX2
+        return SimdSse42;
+    if((xcr0&0xe0)!=0xe0||!(info[1]&(1<<16))||!(info[1]&(1<<30))) // ZMM state, AVX-512F, AVX-512BW
+        return SimdAvx2;
+    return SimdAvx512;
+#else
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("sse4.2"))
+        return SimdScalar;
+    if(!__builtin_cpu_supports("avx2"))
+        return SimdSse42;
+    if(!__builtin_cpu_supports("avx512f")||!__builtin_cpu_supports("avx512bw"))
+        return SimdAvx2;
+    return SimdAvx512;
+#endif
+#else
+    return SimdScalar;
+#endif
+}
+
+static int simdLevelFromEnvironment(int detectedLevel)
+{
+    const char *value=getenv(SIMD_LEVEL_ENV_VAR);
+    if(value==0)
+        return detectedLevel;
+    for(int level=RotationEngine::SimdScalar;level<=RotationEngine::SimdAvx512;level++)
+    {
+        if(strcmp(value,RotationEngine::simdLevelName(level))==0)
+            return __min(level,detectedLevel);
+    }
+    return detectedLevel;
+}
+
+static RotationKernels bindKernels(int level)
+{
+    RotationKernels k;
+    k.simdLevel=level;
+    k.interiorRows[RotationEngine::NearestNeighbor]=RotationEngine::fixedNearestNeighborInteriorRow;
+    k.interiorRows[RotationEngine::Bilinear]=RotationEngine::fixedBilinearInteriorRow;
+    k.interiorRows[RotationEngine::ThreeShear]=0;
+    k.interiorRows[RotationEngine::Bicubic]=RotationEngine::fixedBicubicInteriorRow;
+    k.interiorRows[RotationEngine::Lanczos3]=RotationEngine::fixedLanczos3InteriorRow;
+    k.shearRow=RotationEngine::shearRow;
+    k.transpose=RotationEngine::transposeBlock;
+    k.rotate90=RotationEngine::rotate90Rows;
+    k.rotate180=RotationEngine::rotate180Rows;
+    k.rotate270=RotationEngine::rotate270Rows;
+    k.flipVertically=RotationEngine::flipVerticallyRows;
+    k.flipHorizontally=RotationEngine::flipHorizontallyRows;
+    k.rotate180InPlace=RotationEngine::rotate180InPlaceRows;
+    k.flipVerticallyInPlace=RotationEngine::flipVerticallyInPlaceRows;
+    k.flipHorizontallyInPlace=RotationEngine::flipHorizontallyInPlaceRows;
+    k.convertScanLines=RotationEngine::convertScanLineRows;
+#ifdef ROTATIONENGINE_X86
+    if(level>=RotationEngine::SimdSse42)
+    {
+        k.interiorRows[RotationEngine::Bilinear]=RotationEngine::fixedBilinearInteriorRowSse42;
+        k.interiorRows[RotationEngine::Bicubic]=RotationEngine::fixedBicubicInteriorRowSse42;
+        k.interiorRows[RotationEngine::Lanczos3]=RotationEngine::fixedLanczos3InteriorRowSse42;
+        k.shearRow=RotationEngine::shearRowSse42;
+        k.transpose=RotationEngine::transposeBlockSse42;
+        k.rotate90=RotationEngine::rotate90RowsSse42;
+        k.rotate270=RotationEngine::rotate270RowsSse42;
+        k.rotate180=RotationEngine::rotate180RowsSse42;
+        k.flipHorizontally=RotationEngine::flipHorizontallyRowsSse42;
+        k.rotate180InPlace=RotationEngine::rotate180InPlaceRowsSse42;
+        k.flipHorizontallyInPlace=RotationEngine::flipHorizontallyInPlaceRowsSse42;
+    }
+    if(level>=RotationEngine::SimdAvx2)
+    {
+        k.interiorRows[RotationEngine::NearestNeighbor]=RotationEngine::fixedNearestNeighborInteriorRowAvx2;
+        k.interiorRows[RotationEngine::Bilinear]=RotationEngine::fixedBilinearInteriorRowAvx2;
+        k.interiorRows[RotationEngine::Bicubic]=RotationEngine::fixedBicubicInteriorRowAvx2;
+        k.interiorRows[RotationEngine::Lanczos3]=RotationEngine::fixedLanczos3InteriorRowAvx2;
+        k.shearRow=RotationEngine::shearRowAvx2;
+        k.transpose=RotationEngine::transposeBlockAvx2;
+        k.rotate90=RotationEngine::rotate90RowsAvx2;
+        k.rotate270=RotationEngine::rotate270RowsAvx2;
+        k.rotate180=RotationEngine::rotate180RowsAvx2;
+        k.flipHorizontally=RotationEngine::flipHorizontallyRowsAvx2;
+        k.rotate180InPlace=RotationEngine::rotate180InPlaceRowsAvx2;
+        k.flipHorizontallyInPlace=RotationEngine::flipHorizontallyInPlaceRowsAvx2;
+    }
+    if(level>=RotationEngine::SimdAvx512)
+    {
+        k.interiorRows[RotationEngine::NearestNeighbor]=RotationEngine::fixedNearestNeighborInteriorRowAvx512;
+        k.interiorRows[RotationEngine::Bilinear]=RotationEngine::fixedBilinearInteriorRowAvx512;
+        k.interiorRows[RotationEngine::Bicubic]=RotationEngine::fixedBicubicInteriorRowAvx512;
+        k.interiorRows[RotationEngine::Lanczos3]=RotationEngine::fixedLanczos3InteriorRowAvx512;
+        k.shearRow=RotationEngine::shearRowAvx512;
+        k.rotate180=RotationEngine::rotate180RowsAvx512;
+        k.flipHorizontally=RotationEngine::flipHorizontallyRowsAvx512;
+        k.rotate180InPlace=RotationEngine::rotate180InPlaceRowsAvx512;
+        k.flipHorizontallyInPlace=RotationEngine::flipHorizontallyInPlaceRowsAvx512;
+    }
+#endif
+    return k;
+}
+
+static RotationKernels currentKernels=bindKernels(simdLevelFromEnvironment(RotationEngine::detectSimdLevel()));
+
+const RotationKernels &RotationEngine::kernels()
+{
+    return currentKernels;
+}
+
+void RotationEngine::setSimdLevel(int level)
+{
+    // Not thread-safe; call while no transformation is running
+
+    currentKernels=bindKernels(__max(SimdScalar,__min(level,detectSimdLevel())));
+}
+
+const char *RotationEngine::simdLevelName(int level)
+{
+    switch(level)
+    {
+    case SimdSse42:
+        return "sse4.2";
+    case SimdAvx2:
+        return "avx2";
+    case SimdAvx512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+static int threadCountFromEnvironment()
+{
+    const char *value=getenv(THREAD_COUNT_ENV_VAR);
+    int count=value!=0?atoi(value):0;
+    if(count<=0)
+        count=(int)std::thread::hardware_concurrency();
+    return __max(count,1);
+}
+
+// Operations running on other threads keep their own reference to the pool, so replacing it does not free it under them
+
+static int configuredThreadCount=threadCountFromEnvironment();
+static std::shared_ptr<ThreadPool> threadPool;
+static std::mutex threadPoolMutex;
+
+void RotationEngine::setThreadCount(int count)
+{
+    std::shared_ptr<ThreadPool> oldPool;
+    {
+        std::lock_guard<std::mutex> lock(threadPoolMutex);
+        if(count<=0)
+            count=(int)std::thread::hardware_concurrency();
+        count=__max(count,1);
+        if(count==configuredThreadCount)
+            return;
+        configuredThreadCount=count;
+
+        // Recreated with the new size on next use
+
+        oldPool.swap(threadPool);
+    }
+
+    // The old workers are joined here if no operation uses them, otherwise by the last one to finish
+}
+
+int RotationEngine::threadCount()
+{
+    std::lock_guard<std::mutex> lock(threadPoolMutex);
+    return configuredThreadCount;
+}
+
+static thread_local const std::atomic<bool> *cancelFlag=0;
+
+void RotationEngine::setCancelFlag(const std::atomic<bool> *flag)
+{
+    cancelFlag=flag;
+}
+
+void RotationEngine::parallelRows(int rowCount, const std::function<void(int,int)> &func)
+{
+    parallelFor(rowCount,MIN_ROWS_PER_BAND,func);
+}
+
+void RotationEngine::parallelFor(int count, int minBandSize, const std::function<void(int,int)> &func)
+{
+    std::shared_ptr<ThreadPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(threadPoolMutex);
+        if(!threadPool)
+            threadPool=std::make_shared<ThreadPool>(configuredThreadCount);
+        pool=threadPool;
+    }
+
+    // Workers check the flag of the thread that started the operation
+
+    const std::atomic<bool> *flag=cancelFlag;
+    if(flag==0)
+    {
+        pool->run(count,minBandSize,func);
+        return;
+    }
+    pool->run(count,minBandSize,[&](int start,int end)
+    {
+        if(!*flag)
+            func(start,end);
+    });
+}
+
+static int configuredTileSize=__max(0,getenv(TILE_SIZE_ENV_VAR)!=0?atoi(getenv(TILE_SIZE_ENV_VAR)):0);
+
+void RotationEngine::setTileSize(int size)
+{
+    configuredTileSize=__max(size,0);
+}
+
+int RotationEngine::getTileSize(decimal_t xStepX, decimal_t xStepY)
+{
+    if(configuredTileSize>0)
+        return configuredTileSize;
+
+    // A square destination tile of size t reads a source area of about (t*(|xStepX|+|xStepY|))^2 pixels,
+    // so choose the largest tile whose source footprint fits TILE_CACHE_BYTES.
+
+    decimal_t footprintScale=fabs(xStepX)+fabs(xStepY);
+    int size=(int)(sqrt((decimal_t)TILE_CACHE_BYTES/sizeof(uint32_t))/__max(footprintScale,(decimal_t)1.0));
+    size&=~(TILE_SIZE_GRANULARITY-1);
+    return __max(size,TILE_SIZE_GRANULARITY);
+}
+
+void RotationEngine::forEachTileRow(int newWidth, int newHeight, int tileSize, const std::function<void(int,int,int)> &rowSegment)
+{
+    // Rows of tiles are distributed over the thread pool; each tile is processed row by row.
+
+    int tileRows=(newHeight+tileSize-1)/tileSize;
+    parallelFor(tileRows,1,[&](int tileRowStart,int tileRowEnd)
+    {
+        for(int tileRow=tileRowStart;tileRow<tileRowEnd;tileRow++)
+        {
+            int yStart=tileRow*tileSize;
+            int yEnd=__min(yStart+tileSize,newHeight);
+            for(int xStart=0;xStart<newWidth;xStart+=tileSize)
+            {
+                int count=__min(tileSize,newWidth-xStart);
+                for(int y=yStart;y<yEnd;y++)
+                    rowSegment(xStart,y,count);
+            }
+        }
+    });
+}
@@ -0,0 +1,402 @@
+#ifndef ROTATIONENGINE_H
+#define ROTATIONENGINE_H
+
+#ifndef _USE_MATH_DEFINES
+#define _USE_MATH_DEFINES
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <functional>
+#include <atomic>
+
+#include "extcolordefs.h"
+
+#if defined(__x86_64__)||defined(_M_X64)||defined(__i386__)||defined(_M_IX86)
+#define ROTATIONENGINE_X86
+#endif
+
+// SIMD kernels are compiled for their instruction set using function attributes, so no per-file compiler flags are needed.
+// They are only called after the CPU has been checked for support (see RotationEngine::kernels()).
+
+#if defined(__GNUC__)||defined(__clang__)
+#define ROTATIONENGINE_TARGET_SSE42 __attribute__((target("sse4.2")))
+#define ROTATIONENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+#define ROTATIONENGINE_TARGET_AVX512 __attribute__((target("avx2,avx512f,avx512bw")))
+#else
+#define ROTATIONENGINE_TARGET_SSE42
+#define ROTATIONENGINE_TARGET_AVX2
+#define ROTATIONENGINE_TARGET_AVX512
+#endif
+
+// Environment variable that limits the SIMD level chosen at startup: "scalar", "sse4.2", "avx2" or "avx512"
+
+#define SIMD_LEVEL_ENV_VAR "IMAGEROTATOR_SIMD"
+
+// Environment variable setting the number of worker threads; defaults to the number of hardware threads
+
+#define THREAD_COUNT_ENV_VAR "IMAGEROTATOR_THREADS"
+
+// Smallest band of destination rows handed to a worker thread
+
+#define MIN_ROWS_PER_BAND 8
+
+// Arbitrary-angle rotations process the destination in square tiles whose source footprint fits this many bytes
+// (half of a typical L2 cache). The tile size can be fixed using IMAGEROTATOR_TILE_SIZE or RotationEngine::setTileSize().
+
+#define TILE_CACHE_BYTES (128*1024)
+#define TILE_SIZE_GRANULARITY 16
+#define TILE_SIZE_ENV_VAR "IMAGEROTATOR_TILE_SIZE"
+
+// 90 and 270 degree rotations transpose the image in tiles of this size (16 KiB of source pixels fit L1)
+
+#define TRANSPOSE_TILE_SIZE 64
+
+// Three-shear rotations shear columns in strips of this width (a cache line of pixels). The rows of a strip are sheared
+// and transposed into columns in blocks of SHEAR_BLOCK_ROWS.
+
+#define SHEAR_STRIP_WIDTH 16
+#define SHEAR_BLOCK_ROWS 8
+
+// In-place vertical flips swap rows through a stack buffer of this many pixels
+
+#define IN_PLACE_CHUNK_SIZE 1024
+
+// Headless image transformation engine. Does not depend on Qt, so it can be used by batch workers and benchmarks.
+// All pixel buffers are tightly packed 0xAARRGGBB values. Returned buffers are allocated using malloc() and must be released using free().
+
+typedef double decimal_t;
+
+#define decimalDiv(a,b) ((decimal_t)(((decimal_t)(a))/((decimal_t)(b))))
+
+// Coordinates accumulated along a row may differ from the analytic ones by rounding errors. Pixels mapping
+// within this distance of a bound are resampled by the kernels that check bounds.
+
+#define SPAN_MARGIN 1e-6
+
+// Inverse mapping of a destination image onto its source: destination pixel (x,y) samples the source at
+// (originX+(left+x)*xStepX+(top+y)*yStepX, originY+(left+x)*xStepY+(top+y)*yStepY). A window of a larger destination keeps the origin
+// of the whole one and is placed in it by (left,top), so that its pixels get exactly the coordinates they have there.
+
+struct RotationGeometry
+{
+    int newWidth,newHeight;
+    int left,top;
+    decimal_t originX,originY;
+    decimal_t xStepX,xStepY;
+    decimal_t yStepX,yStepY;
+};
+
+// Fixed-point counterpart of RotationGeometry, used by the bit-exact integer path.
+// Coordinates are accumulated as 32.32 values (fixed_t), so stepping across very wide rows does not drift;
+// kernels sample them at 16.16 precision and quantize bilinear weights to BILINEAR_WEIGHT_BITS.
+
+typedef int64_t fixed_t;
+
+#define FIXED_SHIFT 32
+#define FIXED_ONE (((fixed_t)1)<<FIXED_SHIFT)
+#define FIXED_HALF (((fixed_t)1)<<(FIXED_SHIFT-1))
+#define fixedToInt(a) ((int32_t)((a)>>FIXED_SHIFT))
+#define fixedFraction16(a) ((uint32_t)(((uint64_t)(a)>>(FIXED_SHIFT-16))&0xffff))
+#define BILINEAR_WEIGHT_BITS 7
+#define BILINEAR_WEIGHT_ONE (1<<BILINEAR_WEIGHT_BITS)
+#define fixedToDecimal(a) ((decimal_t)(a)/(decimal_t)FIXED_ONE)
+#define decimalToFixed(a) ((fixed_t)floor((a)*(decimal_t)FIXED_ONE+0.5))
+#define bilinearWeight(a) ((uint32_t)(fixedFraction16(a)>>(16-BILINEAR_WEIGHT_BITS)))
+
+// Bicubic weights are tabulated for BICUBIC_PHASES fractional positions, as four taps in units of 1/BICUBIC_WEIGHT_ONE summing to one
+
+#define BICUBIC_PHASE_BITS 7
+#define BICUBIC_PHASES (1<<BICUBIC_PHASE_BITS)
+#define BICUBIC_WEIGHT_BITS 8
+#define BICUBIC_WEIGHT_ONE (1<<BICUBIC_WEIGHT_BITS)
+#define bicubicPhase(a) ((int)(fixedFraction16(a)>>(16-BICUBIC_PHASE_BITS)))
+
+// Lanczos-3 weights likewise, for 6 taps with finer weights; table rows are padded to 8 taps so that one fills a 128-bit register
+
+#define LANCZOS_TAPS 6
+#define LANCZOS_TABLE_STRIDE 8
+#define LANCZOS_PHASE_BITS 7
+#define LANCZOS_PHASES (1<<LANCZOS_PHASE_BITS)
+#define LANCZOS_WEIGHT_BITS 10
+#define LANCZOS_WEIGHT_ONE (1<<LANCZOS_WEIGHT_BITS)
+#define lanczosPhase(a) ((int)(fixedFraction16(a)>>(16-LANCZOS_PHASE_BITS)))
+
+struct FixedRotationGeometry
+{
+    int newWidth,newHeight;
+    fixed_t originX,originY;
+    fixed_t xStepX,xStepY;
+    fixed_t yStepX,yStepY;
+};
+
+// Forward affine mapping used by RotationEngine::transform(): source pixel (x,y) goes to (m11*x+m12*y+dx, m21*x+m22*y+dy).
+// Pixel centers lie at integer coordinates, so flips, rotations, scaling and translation can be combined into one matrix.
+
+struct AffineTransform
+{
+    decimal_t m11,m12,dx;
+    decimal_t m21,m22,dy;
+};
+
+// Source pixels as resample() reads them: rows lie "stride" pixels apart, and a guard band of "guardBand" pixels on every side repeats
+// the edge pixels. RotationEngine::padImage() builds images with a GUARD_BAND wide band, which holds every neighbour the methods read
+// around a pixel inside the image; resampling them needs no checking kernels unless the border mode mirrors or wraps the source.
+
+#define GUARD_BAND 3 // Lanczos-3 reads up to three pixels beyond the truncated coordinate
+#define PADDED_STRIDE_ALIGNMENT 16 // Pixels (64 bytes): the first pixel of every padded row starts a cache line, so rows can be read with aligned vector loads
+
+struct SourceImage
+{
+    const uint32_t *data; // Pixel (0,0)
+    int width,height;
+    int stride;
+    int guardBand; // 0 for an unpadded image
+};
+
+// Resamples "count" destination pixels of a row; the source coordinate starts at (x,y) and advances by (xStepX,xStepY) per pixel.
+// Dispatched kernels do not check bounds: every pixel must map inside the source, together with all the neighbours the method reads.
+// Source rows lie "stride" pixels apart.
+typedef void (*ResampleRowFunc)(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+// Double-precision counterpart of ResampleRowFunc. out[i] samples (x+(first+i)*xStepX,y+(first+i)*xStepY): coordinates are evaluated from
+// the start (x,y) of the whole row instead of being accumulated, so that they do not depend on where a span starts.
+typedef void (*DoubleRowFunc)(const uint32_t *data,int width,int height,int stride,uint32_t *out,int first,int count,decimal_t x,decimal_t y,decimal_t xStepX,decimal_t xStepY);
+// Writes destination rows [yStart,yEnd) of a lossless transform of a width*height source
+typedef void (*TransformRowsFunc)(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+// Blends "count" pairs of neighbouring pixels: out[i] is in[i] and in[i+1] mixed by weight/BILINEAR_WEIGHT_ONE. Reads count+1 pixels.
+typedef void (*ShearRowFunc)(const uint32_t *in,uint32_t *out,int count,uint32_t weight);
+// Writes the transpose of a width*height block: out[x*outStride+y]=in[y*inStride+x]
+typedef void (*TransposeFunc)(const uint32_t *in,int inStride,uint32_t *out,int outStride,int width,int height);
+// Transforms a width*height image in place; [yStart,yEnd) selects rows or, for transforms that swap rows, row pairs
+typedef void (*InPlaceRowsFunc)(uint32_t *data,int width,int height,int yStart,int yEnd);
+// Converts rows [yStart,yEnd) of 32-bit scan lines to tightly packed 0xAARRGGBB values
+typedef void (*ConvertRowsFunc)(const uint8_t *bits,int bytesPerLine,int width,uint32_t *out,int yStart,int yEnd);
+
+// Number of RotationEngine::Method and RotationEngine::BorderMode values
+
+#define METHOD_COUNT 5
+#define BORDER_MODE_COUNT 5
+
+// Pixel kernels bound to the best implementation the CPU supports
+
+struct RotationKernels
+{
+    int simdLevel;
+    ResampleRowFunc interiorRows[METHOD_COUNT]; // Indexed by RotationEngine::Method; 0 for methods that do not resample rows
+    ShearRowFunc shearRow;
+    TransposeFunc transpose;
+    TransformRowsFunc rotate90;
+    TransformRowsFunc rotate180;
+    TransformRowsFunc rotate270;
+    TransformRowsFunc flipVertically;
+    TransformRowsFunc flipHorizontally;
+    InPlaceRowsFunc rotate180InPlace;
+    InPlaceRowsFunc flipVerticallyInPlace;
+    InPlaceRowsFunc flipHorizontallyInPlace;
+    ConvertRowsFunc convertScanLines;
+};
+
+// Pixels are 0xAARRGGBB with the colour channels premultiplied by alpha, so that interpolation does not bleed the colour of
+// transparent pixels into their neighbours. The kernels keep every colour channel at or below alpha.
+
+class RotationEngine
+{
+public:
+    enum Method
+    {
+        NearestNeighbor=0,
+        Bilinear=1,
+        ThreeShear=2, // Three 1D shears (Paeth); always uses fixed-point weights
+        Bicubic=3, // Catmull-Rom spline over 4x4 pixels; always uses fixed-point weights
+        Lanczos3=4 // Windowed sinc over 6x6 pixels; always uses fixed-point weights
+    };
+
+    // What destination pixels see beyond the edges of the source. Applied by the resampling kernels, in the same pass.
+
+    enum BorderMode
+    {
+        BorderTransparent=0, // Pixels mapping outside are left zero; neighbours beyond the edges repeat the edge pixels
+        BorderConstant=1, // As BorderTransparent, but pixels mapping outside get the border colour
+        BorderClamp=2, // The edge pixels extend indefinitely
+        BorderMirror=3, // The source is reflected about its edges
+        BorderWrap=4 // The source repeats as tiles
+    };
+
+    enum Precision
+    {
+        DoublePrecision=0, // decimal_t coordinates and weights
+        FixedPoint=1 // Integer coordinates and weights; bit-identical on every machine
+    };
+
+    enum SimdLevel
+    {
+        SimdScalar=0,
+        SimdSse42=1,
+        SimdAvx2=2,
+        SimdAvx512=3 // AVX-512F and AVX-512BW
+    };
+
+    static int normalizeDegs(int degs);
+    // borderColor is premultiplied and only used by BorderConstant. Three-shear rotations only support transparent borders
+    // and are done bilinearly otherwise.
+    static uint32_t *rotate(const uint32_t *data,int width,int height,int degs,int method,int precision,int &newWidth,int &newHeight,int border=BorderTransparent,uint32_t borderColor=0);
+    static uint32_t *transform(const uint32_t *data,int width,int height,const AffineTransform &matrix,int newWidth,int newHeight,int method,int precision,int border=BorderTransparent,uint32_t borderColor=0); // 0 if the matrix is singular
+    static uint32_t *transform(const SourceImage &source,const AffineTransform &matrix,int newWidth,int newHeight,int method,int precision,int border=BorderTransparent,uint32_t borderColor=0);
+    // Window of the output of rotate(): regionWidth*regionHeight pixels starting at (x,y), which may extend beyond it. Only the window
+    // is resampled and allocated. Pixels inside the output of rotate() are bit-identical to it in both precisions; beyond it, the
+    // same mapping continues. Quarter turns use nearest neighbour, which reproduces them exactly; three shears resample bilinearly.
+    static uint32_t *rotateRegion(const uint32_t *data,int width,int height,int degs,int method,int precision,int x,int y,int regionWidth,int regionHeight,int border=BorderTransparent,uint32_t borderColor=0);
+    // Output of rotate() cropped to the largest axis-aligned rectangle that lies inside the rotated source, so that it has no
+    // transparent corners. Only the pixels of the rectangle are resampled; three shears are replaced by bilinear resampling.
+    static uint32_t *rotateCropped(const uint32_t *data,int width,int height,int degs,int method,int precision,int &newWidth,int &newHeight);
+    static void getInscribedRectangle(int width,int height,int degs,int &x,int &y,int &cropWidth,int &cropHeight); // Within the output of rotate()
+    static AffineTransform rotationTransform(int width,int height,int degs,int &newWidth,int &newHeight); // Same mapping and size as rotate() in double precision
+    static AffineTransform combineTransforms(const AffineTransform &first,const AffineTransform &second); // Applies first, then second
+    static RotationGeometry getRotationGeometry(int width,int height,int degs);
+    static FixedRotationGeometry getFixedRotationGeometry(int width,int height,int degs);
+    static uint32_t *rotateThreeShear(const uint32_t *data,int width,int height,int degs,int &newWidth,int &newHeight);
+
+    // Resamples geometry.newWidth*geometry.newHeight destination pixels. With BorderTransparent, pixels mapping outside the source are
+    // not written, so the buffer must be zeroed; the other border modes write every pixel.
+    // The double-precision variant supports NearestNeighbor and Bilinear only.
+
+    static void resample(const uint32_t *data,int width,int height,uint32_t *newImageData,const FixedRotationGeometry &geometry,int method,int border,uint32_t borderColor);
+    static void resample(const uint32_t *data,int width,int height,uint32_t *newImageData,const RotationGeometry &geometry,int method,int border,uint32_t borderColor);
+    static void resample(const SourceImage &source,uint32_t *newImageData,const FixedRotationGeometry &geometry,int method,int border,uint32_t borderColor);
+    static void resample(const SourceImage &source,uint32_t *newImageData,const RotationGeometry &geometry,int method,int border,uint32_t borderColor);
+    static SourceImage sourceImage(const uint32_t *data,int width,int height); // Unpadded
+    static uint32_t *padImage(const uint32_t *data,int width,int height,SourceImage &image); // Copies data into a padded buffer, returned for free()
+    static uint32_t *halveImage(const SourceImage &source,SourceImage &image); // Box-filtered to half the size, rounded up; source needs a guard band
+    static uint32_t *flipVertically(const uint32_t *data,int width,int height);
+    static uint32_t *flipHorizontally(const uint32_t *data,int width,int height);
+    static uint32_t *bitmapDataFromScanLines(const uint8_t *bits,int bytesPerLine,int width,int height);
+
+    // In-place variants, which need no second image buffer, and only reverse rows instead of resampling. The main window keeps the
+    // loaded image for further edits, so it applies them to its own copy when saving a flip or a half turn.
+
+    static void rotate180InPlace(uint32_t *data,int width,int height);
+    static void flipVerticallyInPlace(uint32_t *data,int width,int height);
+    static void flipHorizontallyInPlace(uint32_t *data,int width,int height);
+    static decimal_t bilinearInterpolate(decimal_t c00, decimal_t c10, decimal_t c01, decimal_t c11, decimal_t w1, decimal_t w2, decimal_t w3, decimal_t w4);
+    static const int16_t *bicubicWeights(); // BICUBIC_PHASES rows of 4 taps, for pixels -1..2 around the sample point
+    static const int16_t *lanczos3Weights(); // LANCZOS_PHASES rows of LANCZOS_TABLE_STRIDE taps, for pixels -2..3 around the sample point
+
+    // Dispatch
+
+    static int detectSimdLevel();
+    static const RotationKernels &kernels();
+    static void setSimdLevel(int level); // Clamped to what the CPU supports
+    static const char *simdLevelName(int level);
+
+    // Threading
+
+    // Any thread may start operations, and the thread count may change while they run. Operations started concurrently take turns
+    // on the pool; one started from inside a band of another runs single-threaded on that band's thread.
+
+    static void setThreadCount(int count); // 0: number of hardware threads
+    static int threadCount();
+    static void parallelRows(int rowCount,const std::function<void(int,int)> &func);
+    static void parallelFor(int count,int minBandSize,const std::function<void(int,int)> &func);
+
+    // Cancellation: once *flag is set, operations started on the calling thread skip the bands of rows they have not begun.
+    // Their result is then incomplete, and only good for free(). 0 detaches the flag.
+
+    static void setCancelFlag(const std::atomic<bool> *flag);
+
+    // Tiling
+
+    static void setTileSize(int size); // 0: derived from TILE_CACHE_BYTES and the angle
+    static int getTileSize(decimal_t xStepX,decimal_t xStepY);
+    static void forEachTileRow(int newWidth,int newHeight,int tileSize,const std::function<void(int,int,int)> &rowSegment);
+
+    // Portable kernels (rotationengine_scalar.cpp). Row kernels without "Interior" check bounds; they handle the edges of the valid span.
+
+    static void doubleNearestNeighborRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int first,int count,decimal_t x,decimal_t y,decimal_t xStepX,decimal_t xStepY);
+    static void doubleBilinearRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int first,int count,decimal_t x,decimal_t y,decimal_t xStepX,decimal_t xStepY);
+    static void doubleNearestNeighborInteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int first,int count,decimal_t x,decimal_t y,decimal_t xStepX,decimal_t xStepY);
+    static void doubleBilinearInteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int first,int count,decimal_t x,decimal_t y,decimal_t xStepX,decimal_t xStepY);
+
+    static void fixedNearestNeighborRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBilinearRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedNearestNeighborInteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBilinearInteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBicubicRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBicubicInteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedLanczos3Row(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedLanczos3InteriorRow(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static ResampleRowFunc fixedEdgeRow(int method,int border); // Checking kernel for a border mode; 0 if the method has none
+    static DoubleRowFunc doubleEdgeRow(int method,int border);
+    static void shearRow(const uint32_t *in,uint32_t *out,int count,uint32_t weight);
+    static void transposeBlock(const uint32_t *in,int inStride,uint32_t *out,int outStride,int width,int height);
+    static void rotate90Block(const uint32_t *data,int width,int height,uint32_t *out,int xStart,int xEnd,int yStart,int yEnd);
+    static void rotate90Rows(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRow(const uint32_t *in,uint32_t *out,int count);
+    static void rotate180Rows(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void rotate270Block(const uint32_t *data,int width,int height,uint32_t *out,int xStart,int xEnd,int yStart,int yEnd);
+    static void rotate270Rows(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void flipVerticallyRows(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void flipHorizontallyRows(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowInPlace(uint32_t *row,int count);
+    static void reverseSwapRows(uint32_t *a,uint32_t *b,int count);
+    static void rotate180InPlaceRows(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void flipVerticallyInPlaceRows(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void flipHorizontallyInPlaceRows(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void convertScanLineRows(const uint8_t *bits,int bytesPerLine,int width,uint32_t *out,int yStart,int yEnd);
+    static void halveRow(const uint32_t *in,int stride,uint32_t *out,int count);
+
+#ifdef ROTATIONENGINE_X86
+    // SSE4.2 kernels (rotationengine_sse42.cpp)
+
+    static void fixedBilinearInteriorRowSse42(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBicubicInteriorRowSse42(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedLanczos3InteriorRowSse42(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void shearRowSse42(const uint32_t *in,uint32_t *out,int count,uint32_t weight);
+    static void transposeBlockSse42(const uint32_t *in,int inStride,uint32_t *out,int outStride,int width,int height);
+    static void rotate90RowsSse42(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void rotate270RowsSse42(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowSse42(const uint32_t *in,uint32_t *out,int count);
+    static void rotate180RowsSse42(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void flipHorizontallyRowsSse42(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowInPlaceSse42(uint32_t *row,int count);
+    static void reverseSwapRowsSse42(uint32_t *a,uint32_t *b,int count);
+    static void rotate180InPlaceRowsSse42(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void flipHorizontallyInPlaceRowsSse42(uint32_t *data,int width,int height,int yStart,int yEnd);
+
+    // AVX2 kernels (rotationengine_avx2.cpp)
+
+    static void fixedNearestNeighborInteriorRowAvx2(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBilinearInteriorRowAvx2(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBicubicInteriorRowAvx2(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedLanczos3InteriorRowAvx2(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void shearRowAvx2(const uint32_t *in,uint32_t *out,int count,uint32_t weight);
+    static void transposeBlockAvx2(const uint32_t *in,int inStride,uint32_t *out,int outStride,int width,int height);
+    static void rotate90RowsAvx2(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void rotate270RowsAvx2(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowAvx2(const uint32_t *in,uint32_t *out,int count);
+    static void rotate180RowsAvx2(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void flipHorizontallyRowsAvx2(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowInPlaceAvx2(uint32_t *row,int count);
+    static void reverseSwapRowsAvx2(uint32_t *a,uint32_t *b,int count);
+    static void rotate180InPlaceRowsAvx2(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void flipHorizontallyInPlaceRowsAvx2(uint32_t *data,int width,int height,int yStart,int yEnd);
+
+    // AVX-512 kernels (rotationengine_avx512.cpp)
+
+    static void fixedNearestNeighborInteriorRowAvx512(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBilinearInteriorRowAvx512(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedBicubicInteriorRowAvx512(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void fixedLanczos3InteriorRowAvx512(const uint32_t *data,int width,int height,int stride,uint32_t *out,int count,fixed_t x,fixed_t y,fixed_t xStepX,fixed_t xStepY);
+    static void shearRowAvx512(const uint32_t *in,uint32_t *out,int count,uint32_t weight);
+    static void reverseRowAvx512(const uint32_t *in,uint32_t *out,int count);
+    static void rotate180RowsAvx512(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void flipHorizontallyRowsAvx512(const uint32_t *data,int width,int height,uint32_t *out,int yStart,int yEnd);
+    static void reverseRowInPlaceAvx512(uint32_t *row,int count);
+    static void reverseSwapRowsAvx512(uint32_t *a,uint32_t *b,int count);
+    static void rotate180InPlaceRowsAvx512(uint32_t *data,int width,int height,int yStart,int yEnd);
+    static void flipHorizontallyInPlaceRowsAvx512(uint32_t *data,int width,int height,int yStart,int yEnd);
+#endif
+};
+
+#endif // ROTATIONENGINE_H
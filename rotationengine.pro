@@ -0,0 +1,22 @@
+#-------------------------------------------------
+#
+# Headless rotation engine (no QApplication, no widgets)
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = rotationengine
+TEMPLATE = lib
+CONFIG += staticlib c++11 thread
+
+SOURCES += rotationengine.cpp \
+    rotationengine_scalar.cpp \
+    rotationengine_sse42.cpp \
+    rotationengine_avx2.cpp \
+    rotationengine_avx512.cpp \
+    threadpool.cpp
+
+HEADERS += rotationengine.h \
+    threadpool.h \
+    extcolordefs.h
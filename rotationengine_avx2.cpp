@@ -0,0 +1,473 @@
+#include "rotationengine.h"
+
+#ifdef ROTATIONENGINE_X86
+
+#include <immintrin.h>
+
+// AVX2 kernels processing 8 destination pixels per iteration.
+// They produce exactly the same output as their counterparts in rotationengine_scalar.cpp.
+
+// Integer parts (high dwords) or fractions (low dwords) of two vectors of four 32.32 values, in pixel order
+
+#define hiDwords(a,b) _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(a),_mm256_castsi256_ps(b),_MM_SHUFFLE(3,1,3,1))),_MM_SHUFFLE(3,1,2,0))
+#define loDwords(a,b) _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(a),_mm256_castsi256_ps(b),_MM_SHUFFLE(2,0,2,0))),_MM_SHUFFLE(3,1,2,0))
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::fixedNearestNeighborInteriorRowAvx2(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    const __m256i strideV=_mm256_set1_epi32(stride);
+    const __m256i halfV=_mm256_set1_epi64x(FIXED_HALF);
+
+    // Rounding offset folded into the start position
+
+    __m256i x0=_mm256_add_epi64(_mm256_set_epi64x(x+3*xStepX,x+2*xStepX,x+xStepX,x),halfV);
+    __m256i x1=_mm256_add_epi64(x0,_mm256_set1_epi64x(4*xStepX));
+    __m256i y0=_mm256_add_epi64(_mm256_set_epi64x(y+3*xStepY,y+2*xStepY,y+xStepY,y),halfV);
+    __m256i y1=_mm256_add_epi64(y0,_mm256_set1_epi64x(4*xStepY));
+    const __m256i xStep8=_mm256_set1_epi64x(8*xStepX);
+    const __m256i yStep8=_mm256_set1_epi64x(8*xStepY);
+
+    int i=0;
+    for(;i+8<=count;i+=8)
+    {
+        __m256i rX=hiDwords(x0,x1);
+        __m256i rY=hiDwords(y0,y1);
+        __m256i index=_mm256_add_epi32(_mm256_mullo_epi32(rY,strideV),rX);
+        _mm256_storeu_si256((__m256i*)(out+i),_mm256_i32gather_epi32((const int*)data,index,4));
+        x0=_mm256_add_epi64(x0,xStep8);
+        x1=_mm256_add_epi64(x1,xStep8);
+        y0=_mm256_add_epi64(y0,yStep8);
+        y1=_mm256_add_epi64(y1,yStep8);
+    }
+    if(i<count)
+        fixedNearestNeighborInteriorRow(data,width,height,stride,out+i,count-i,x+i*xStepX,y+i*xStepY,xStepX,xStepY);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::fixedBilinearInteriorRowAvx2(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    const __m256i zero=_mm256_setzero_si256();
+    const __m256i one=_mm256_set1_epi32(1);
+    const __m256i strideV=_mm256_set1_epi32(stride);
+    const __m256i weightOne=_mm256_set1_epi32(BILINEAR_WEIGHT_ONE);
+    const __m256i rounding=_mm256_set1_epi32(1<<(2*BILINEAR_WEIGHT_BITS-1));
+
+    __m256i x0=_mm256_set_epi64x(x+3*xStepX,x+2*xStepX,x+xStepX,x);
+    __m256i x1=_mm256_add_epi64(x0,_mm256_set1_epi64x(4*xStepX));
+    __m256i y0=_mm256_set_epi64x(y+3*xStepY,y+2*xStepY,y+xStepY,y);
+    __m256i y1=_mm256_add_epi64(y0,_mm256_set1_epi64x(4*xStepY));
+    const __m256i xStep8=_mm256_set1_epi64x(8*xStepX);
+    const __m256i yStep8=_mm256_set1_epi64x(8*xStepY);
+
+    int i=0;
+    for(;i+8<=count;i+=8)
+    {
+        __m256i fX=hiDwords(x0,x1);
+        __m256i fY=hiDwords(y0,y1);
+        __m256i cX=_mm256_add_epi32(fX,one);
+        __m256i cY=_mm256_add_epi32(fY,one);
+
+        __m256i wX=_mm256_srli_epi32(loDwords(x0,x1),FIXED_SHIFT-BILINEAR_WEIGHT_BITS);
+        __m256i wY=_mm256_srli_epi32(loDwords(y0,y1),FIXED_SHIFT-BILINEAR_WEIGHT_BITS);
+
+        __m256i rowF=_mm256_mullo_epi32(fY,strideV);
+        __m256i rowC=_mm256_mullo_epi32(cY,strideV);
+        __m256i c00=_mm256_i32gather_epi32((const int*)data,_mm256_add_epi32(rowF,fX),4);
+        __m256i c10=_mm256_i32gather_epi32((const int*)data,_mm256_add_epi32(rowF,cX),4);
+        __m256i c01=_mm256_i32gather_epi32((const int*)data,_mm256_add_epi32(rowC,fX),4);
+        __m256i c11=_mm256_i32gather_epi32((const int*)data,_mm256_add_epi32(rowC,cX),4);
+
+        // Vertical weights, replicated over the four 16-bit channels of each pixel
+
+        __m256i wYPair=_mm256_or_si256(wY,_mm256_slli_epi32(wY,16));
+        __m256i wYRPair=_mm256_sub_epi16(_mm256_set1_epi16(BILINEAR_WEIGHT_ONE),wYPair);
+        __m256i wYLo=_mm256_unpacklo_epi32(wYPair,wYPair);
+        __m256i wYHi=_mm256_unpackhi_epi32(wYPair,wYPair);
+        __m256i wYRLo=_mm256_unpacklo_epi32(wYRPair,wYRPair);
+        __m256i wYRHi=_mm256_unpackhi_epi32(wYRPair,wYRPair);
+
+        __m256i leftLo=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c00,zero),wYRLo),_mm256_mullo_epi16(_mm256_unpacklo_epi8(c01,zero),wYLo));
+        __m256i leftHi=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c00,zero),wYRHi),_mm256_mullo_epi16(_mm256_unpackhi_epi8(c01,zero),wYHi));
+        __m256i rightLo=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c10,zero),wYRLo),_mm256_mullo_epi16(_mm256_unpacklo_epi8(c11,zero),wYLo));
+        __m256i rightHi=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c10,zero),wYRHi),_mm256_mullo_epi16(_mm256_unpackhi_epi8(c11,zero),wYHi));
+
+        // Horizontal blend: (left,right) pairs times (1-wX,wX) pairs, accumulated in 32 bits
+
+        __m256i wXPair=_mm256_or_si256(_mm256_sub_epi32(weightOne,wX),_mm256_slli_epi32(wX,16));
+        __m256i r0=_mm256_madd_epi16(_mm256_unpacklo_epi16(leftLo,rightLo),_mm256_shuffle_epi32(wXPair,_MM_SHUFFLE(0,0,0,0)));
+        __m256i r1=_mm256_madd_epi16(_mm256_unpackhi_epi16(leftLo,rightLo),_mm256_shuffle_epi32(wXPair,_MM_SHUFFLE(1,1,1,1)));
+        __m256i r2=_mm256_madd_epi16(_mm256_unpacklo_epi16(leftHi,rightHi),_mm256_shuffle_epi32(wXPair,_MM_SHUFFLE(2,2,2,2)));
+        __m256i r3=_mm256_madd_epi16(_mm256_unpackhi_epi16(leftHi,rightHi),_mm256_shuffle_epi32(wXPair,_MM_SHUFFLE(3,3,3,3)));
+        r0=_mm256_srli_epi32(_mm256_add_epi32(r0,rounding),2*BILINEAR_WEIGHT_BITS);
+        r1=_mm256_srli_epi32(_mm256_add_epi32(r1,rounding),2*BILINEAR_WEIGHT_BITS);
+        r2=_mm256_srli_epi32(_mm256_add_epi32(r2,rounding),2*BILINEAR_WEIGHT_BITS);
+        r3=_mm256_srli_epi32(_mm256_add_epi32(r3,rounding),2*BILINEAR_WEIGHT_BITS);
+
+        __m256i result=_mm256_packus_epi16(_mm256_packs_epi32(r0,r1),_mm256_packs_epi32(r2,r3));
+        _mm256_storeu_si256((__m256i*)(out+i),result);
+        x0=_mm256_add_epi64(x0,xStep8);
+        x1=_mm256_add_epi64(x1,xStep8);
+        y0=_mm256_add_epi64(y0,yStep8);
+        y1=_mm256_add_epi64(y1,yStep8);
+    }
+    if(i<count)
+        fixedBilinearInteriorRow(data,width,height,stride,out+i,count-i,x+i*xStepX,y+i*xStepY,xStepX,xStepY);
+}
+
+// Limits the colour channels of eight packed pixels to their alpha, as in clampToAlphaSse42()
+
+ROTATIONENGINE_TARGET_AVX2 static inline __m256i clampToAlphaAvx2(__m256i pixels)
+{
+    const __m256i alphas=_mm256_setr_epi8(3,3,3,3,7,7,7,7,11,11,11,11,15,15,15,15,3,3,3,3,7,7,7,7,11,11,11,11,15,15,15,15);
+    return _mm256_min_epu8(pixels,_mm256_shuffle_epi8(pixels,alphas));
+}
+
+// Two source pixel rows (one per 128-bit lane) blended over 4 taps each, as in bicubicRowSse42()
+
+ROTATIONENGINE_TARGET_AVX2 static inline __m256i bicubicRowAvx2(const uint32_t *rowA, const uint32_t *rowB, __m256i wX01, __m256i wX23)
+{
+    const __m256i pairs01=_mm256_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1,0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1);
+    const __m256i pairs23=_mm256_setr_epi8(8,-1,12,-1,9,-1,13,-1,10,-1,14,-1,11,-1,15,-1,8,-1,12,-1,9,-1,13,-1,10,-1,14,-1,11,-1,15,-1);
+
+    __m256i pixels=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)rowA)),_mm_loadu_si128((const __m128i*)rowB),1);
+    return _mm256_add_epi32(_mm256_madd_epi16(_mm256_shuffle_epi8(pixels,pairs01),wX01),_mm256_madd_epi16(_mm256_shuffle_epi8(pixels,pairs23),wX23));
+}
+
+// Full 4x4 blends of two destination pixels, shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_AVX2 static inline __m256i bicubicPixelsAvx2(const uint32_t *pixelsA, const uint32_t *pixelsB, int stride, const int16_t *wXA, const int16_t *wXB, const int16_t *wYA, const int16_t *wYB)
+{
+    const int shift=2*BICUBIC_WEIGHT_BITS;
+
+    __m256i wXV=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadl_epi64((const __m128i*)wXA)),_mm_loadl_epi64((const __m128i*)wXB),1);
+    __m256i wX01=_mm256_shuffle_epi32(wXV,_MM_SHUFFLE(0,0,0,0));
+    __m256i wX23=_mm256_shuffle_epi32(wXV,_MM_SHUFFLE(1,1,1,1));
+    __m256i wYV=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wYA))),_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wYB)),1);
+
+    __m256i sum=_mm256_set1_epi32(1<<(shift-1));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(bicubicRowAvx2(pixelsA,pixelsB,wX01,wX23),_mm256_shuffle_epi32(wYV,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(bicubicRowAvx2(pixelsA+stride,pixelsB+stride,wX01,wX23),_mm256_shuffle_epi32(wYV,_MM_SHUFFLE(1,1,1,1))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(bicubicRowAvx2(pixelsA+2*stride,pixelsB+2*stride,wX01,wX23),_mm256_shuffle_epi32(wYV,_MM_SHUFFLE(2,2,2,2))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(bicubicRowAvx2(pixelsA+3*stride,pixelsB+3*stride,wX01,wX23),_mm256_shuffle_epi32(wYV,_MM_SHUFFLE(3,3,3,3))));
+    return _mm256_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::fixedBicubicInteriorRowAvx2(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // Gathering 16 taps per pixel would cost more than loading the 4x4 block row by row, so pixels stay in 128-bit lanes
+    // (4 per iteration) and only the blend is widened.
+
+    (void)height;
+    const int16_t *weights=bicubicWeights();
+    const __m256i order=_mm256_setr_epi32(0,4,1,5,0,0,0,0);
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        const uint32_t *pixels[4];
+        const int16_t *wX[4],*wY[4];
+        for(int j=0;j<4;j++,x+=xStepX,y+=xStepY)
+        {
+            pixels[j]=data+(fixedToInt(y)-1)*stride+fixedToInt(x)-1;
+            wX[j]=weights+bicubicPhase(x)*4;
+            wY[j]=weights+bicubicPhase(y)*4;
+        }
+        __m256i r01=bicubicPixelsAvx2(pixels[0],pixels[1],stride,wX[0],wX[1],wY[0],wY[1]);
+        __m256i r23=bicubicPixelsAvx2(pixels[2],pixels[3],stride,wX[2],wX[3],wY[2],wY[3]);
+
+        // The packs work per lane: lane 0 holds pixels 0 and 2, lane 1 pixels 1 and 3
+
+        __m256i packed=clampToAlphaAvx2(_mm256_packus_epi16(_mm256_packs_epi32(r01,r23),_mm256_setzero_si256()));
+        __m256i result=_mm256_permutevar8x32_epi32(packed,order);
+        _mm_storeu_si128((__m128i*)(out+i),_mm256_castsi256_si128(result));
+    }
+    if(i<count)
+        fixedBicubicInteriorRow(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+// Two source pixel rows blended over 6 taps each, as in lanczos3RowSse42()
+
+ROTATIONENGINE_TARGET_AVX2 static inline __m256i lanczos3RowAvx2(const uint32_t *rowA, const uint32_t *rowB, __m256i wX01, __m256i wX23, __m256i wX45)
+{
+    const __m256i pairs01=_mm256_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1,0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1);
+
+    __m256i pixels45=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadl_epi64((const __m128i*)(rowA+4))),_mm_loadl_epi64((const __m128i*)(rowB+4)),1);
+    return _mm256_add_epi32(bicubicRowAvx2(rowA,rowB,wX01,wX23),_mm256_madd_epi16(_mm256_shuffle_epi8(pixels45,pairs01),wX45));
+}
+
+// Full 6x6 blends of two destination pixels, shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_AVX2 static inline __m256i lanczos3PixelsAvx2(const uint32_t *pixelsA, const uint32_t *pixelsB, int stride, const int16_t *wXA, const int16_t *wXB, const int16_t *wYA, const int16_t *wYB)
+{
+    const int shift=2*LANCZOS_WEIGHT_BITS;
+
+    __m256i wXV=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)wXA)),_mm_loadu_si128((const __m128i*)wXB),1);
+    __m256i wX01=_mm256_shuffle_epi32(wXV,_MM_SHUFFLE(0,0,0,0));
+    __m256i wX23=_mm256_shuffle_epi32(wXV,_MM_SHUFFLE(1,1,1,1));
+    __m256i wX45=_mm256_shuffle_epi32(wXV,_MM_SHUFFLE(2,2,2,2));
+    __m256i wYLo=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wYA))),_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wYB)),1);
+    __m256i wYHi=_mm256_inserti128_si256(_mm256_castsi128_si256(_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(wYA+4)))),_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(wYB+4))),1);
+
+    __m256i sum=_mm256_set1_epi32(1<<(shift-1));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA,pixelsB,wX01,wX23,wX45),_mm256_shuffle_epi32(wYLo,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA+stride,pixelsB+stride,wX01,wX23,wX45),_mm256_shuffle_epi32(wYLo,_MM_SHUFFLE(1,1,1,1))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA+2*stride,pixelsB+2*stride,wX01,wX23,wX45),_mm256_shuffle_epi32(wYLo,_MM_SHUFFLE(2,2,2,2))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA+3*stride,pixelsB+3*stride,wX01,wX23,wX45),_mm256_shuffle_epi32(wYLo,_MM_SHUFFLE(3,3,3,3))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA+4*stride,pixelsB+4*stride,wX01,wX23,wX45),_mm256_shuffle_epi32(wYHi,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm256_add_epi32(sum,_mm256_mullo_epi32(lanczos3RowAvx2(pixelsA+5*stride,pixelsB+5*stride,wX01,wX23,wX45),_mm256_shuffle_epi32(wYHi,_MM_SHUFFLE(1,1,1,1))));
+    return _mm256_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::fixedLanczos3InteriorRowAvx2(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // Same layout as fixedBicubicInteriorRowAvx2()
+
+    (void)height;
+    const int16_t *weights=lanczos3Weights();
+    const __m256i order=_mm256_setr_epi32(0,4,1,5,0,0,0,0);
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        const uint32_t *pixels[4];
+        const int16_t *wX[4],*wY[4];
+        for(int j=0;j<4;j++,x+=xStepX,y+=xStepY)
+        {
+            pixels[j]=data+(fixedToInt(y)-2)*stride+fixedToInt(x)-2;
+            wX[j]=weights+lanczosPhase(x)*LANCZOS_TABLE_STRIDE;
+            wY[j]=weights+lanczosPhase(y)*LANCZOS_TABLE_STRIDE;
+        }
+        __m256i r01=lanczos3PixelsAvx2(pixels[0],pixels[1],stride,wX[0],wX[1],wY[0],wY[1]);
+        __m256i r23=lanczos3PixelsAvx2(pixels[2],pixels[3],stride,wX[2],wX[3],wY[2],wY[3]);
+
+        __m256i packed=clampToAlphaAvx2(_mm256_packus_epi16(_mm256_packs_epi32(r01,r23),_mm256_setzero_si256()));
+        __m256i result=_mm256_permutevar8x32_epi32(packed,order);
+        _mm_storeu_si128((__m128i*)(out+i),_mm256_castsi256_si128(result));
+    }
+    if(i<count)
+        fixedLanczos3InteriorRow(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::shearRowAvx2(const uint32_t *in, uint32_t *out, int count, uint32_t weight)
+{
+    const __m256i zero=_mm256_setzero_si256();
+    const __m256i weightV=_mm256_set1_epi16(weight);
+    const __m256i weightRV=_mm256_set1_epi16(BILINEAR_WEIGHT_ONE-weight);
+    const __m256i rounding=_mm256_set1_epi16(1<<(BILINEAR_WEIGHT_BITS-1));
+
+    int i=0;
+    for(;i+8<=count;i+=8)
+    {
+        __m256i c0=_mm256_loadu_si256((const __m256i*)(in+i));
+        __m256i c1=_mm256_loadu_si256((const __m256i*)(in+i+1));
+        __m256i lo=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(c0,zero),weightRV),_mm256_mullo_epi16(_mm256_unpacklo_epi8(c1,zero),weightV));
+        __m256i hi=_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(c0,zero),weightRV),_mm256_mullo_epi16(_mm256_unpackhi_epi8(c1,zero),weightV));
+        lo=_mm256_srli_epi16(_mm256_add_epi16(lo,rounding),BILINEAR_WEIGHT_BITS);
+        hi=_mm256_srli_epi16(_mm256_add_epi16(hi,rounding),BILINEAR_WEIGHT_BITS);
+        _mm256_storeu_si256((__m256i*)(out+i),_mm256_packus_epi16(lo,hi));
+    }
+    if(i<count)
+        shearRow(in+i,out+i,count-i,weight);
+}
+
+// In-register transpose of an 8x8 block of 32-bit pixels: row i becomes column i
+
+ROTATIONENGINE_TARGET_AVX2 static inline void transpose8x8(__m256i *r)
+{
+    __m256i t0=_mm256_unpacklo_epi32(r[0],r[1]);
+    __m256i t1=_mm256_unpackhi_epi32(r[0],r[1]);
+    __m256i t2=_mm256_unpacklo_epi32(r[2],r[3]);
+    __m256i t3=_mm256_unpackhi_epi32(r[2],r[3]);
+    __m256i t4=_mm256_unpacklo_epi32(r[4],r[5]);
+    __m256i t5=_mm256_unpackhi_epi32(r[4],r[5]);
+    __m256i t6=_mm256_unpacklo_epi32(r[6],r[7]);
+    __m256i t7=_mm256_unpackhi_epi32(r[6],r[7]);
+    __m256i u0=_mm256_unpacklo_epi64(t0,t2);
+    __m256i u1=_mm256_unpackhi_epi64(t0,t2);
+    __m256i u2=_mm256_unpacklo_epi64(t1,t3);
+    __m256i u3=_mm256_unpackhi_epi64(t1,t3);
+    __m256i u4=_mm256_unpacklo_epi64(t4,t6);
+    __m256i u5=_mm256_unpackhi_epi64(t4,t6);
+    __m256i u6=_mm256_unpacklo_epi64(t5,t7);
+    __m256i u7=_mm256_unpackhi_epi64(t5,t7);
+    r[0]=_mm256_permute2x128_si256(u0,u4,0x20);
+    r[1]=_mm256_permute2x128_si256(u1,u5,0x20);
+    r[2]=_mm256_permute2x128_si256(u2,u6,0x20);
+    r[3]=_mm256_permute2x128_si256(u3,u7,0x20);
+    r[4]=_mm256_permute2x128_si256(u0,u4,0x31);
+    r[5]=_mm256_permute2x128_si256(u1,u5,0x31);
+    r[6]=_mm256_permute2x128_si256(u2,u6,0x31);
+    r[7]=_mm256_permute2x128_si256(u3,u7,0x31);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::transposeBlockAvx2(const uint32_t *in, int inStride, uint32_t *out, int outStride, int width, int height)
+{
+    int xBlockEnd=width&~7;
+    int yBlockEnd=height&~7;
+    for(int y=0;y<yBlockEnd;y+=8)
+    {
+        for(int x=0;x<xBlockEnd;x+=8)
+        {
+            __m256i r[8];
+            for(int j=0;j<8;j++)
+                r[j]=_mm256_loadu_si256((const __m256i*)(in+(size_t)(y+j)*inStride+x));
+            transpose8x8(r);
+            for(int i=0;i<8;i++)
+                _mm256_storeu_si256((__m256i*)(out+(size_t)(x+i)*outStride+y),r[i]);
+        }
+    }
+
+    // Edges that do not fill a whole block
+
+    if(xBlockEnd<width)
+        transposeBlock(in+xBlockEnd,inStride,out+(size_t)xBlockEnd*outStride,outStride,width-xBlockEnd,height);
+    if(yBlockEnd<height)
+        transposeBlock(in+(size_t)yBlockEnd*inStride,inStride,out+yBlockEnd,outStride,xBlockEnd,height-yBlockEnd);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::rotate90RowsAvx2(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Destination block (x..x+7,y..y+7) is the transpose of source rows height-1-x..height-8-x, columns y..y+7
+
+    int newWidth=height;
+    int yBlockEnd=yStart+((yEnd-yStart)&~7);
+    int xBlockEnd=newWidth&~7;
+    for(int tileY=yStart;tileY<yBlockEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        int tileYEnd=__min(tileY+TRANSPOSE_TILE_SIZE,yBlockEnd);
+        for(int tileX=0;tileX<xBlockEnd;tileX+=TRANSPOSE_TILE_SIZE)
+        {
+            int tileXEnd=__min(tileX+TRANSPOSE_TILE_SIZE,xBlockEnd);
+            for(int y=tileY;y<tileYEnd;y+=8)
+            {
+                for(int x=tileX;x<tileXEnd;x+=8)
+                {
+                    __m256i r[8];
+                    for(int j=0;j<8;j++)
+                        r[j]=_mm256_loadu_si256((const __m256i*)(data+(size_t)(height-1-x-j)*width+y));
+                    transpose8x8(r);
+                    for(int i=0;i<8;i++)
+                        _mm256_storeu_si256((__m256i*)(out+(size_t)(y+i)*newWidth+x),r[i]);
+                }
+            }
+        }
+    }
+
+    // Edges that do not fill a whole block
+
+    if(xBlockEnd<newWidth)
+        rotate90Block(data,width,height,out,xBlockEnd,newWidth,yStart,yBlockEnd);
+    if(yBlockEnd<yEnd)
+        rotate90Block(data,width,height,out,0,newWidth,yBlockEnd,yEnd);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::rotate270RowsAvx2(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Destination block (x..x+7,y..y+7) is the transpose of source rows x..x+7, columns width-8-y..width-1-y, mirrored vertically
+
+    int newWidth=height;
+    int yBlockEnd=yStart+((yEnd-yStart)&~7);
+    int xBlockEnd=newWidth&~7;
+    for(int tileY=yStart;tileY<yBlockEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        int tileYEnd=__min(tileY+TRANSPOSE_TILE_SIZE,yBlockEnd);
+        for(int tileX=0;tileX<xBlockEnd;tileX+=TRANSPOSE_TILE_SIZE)
+        {
+            int tileXEnd=__min(tileX+TRANSPOSE_TILE_SIZE,xBlockEnd);
+            for(int y=tileY;y<tileYEnd;y+=8)
+            {
+                for(int x=tileX;x<tileXEnd;x+=8)
+                {
+                    __m256i r[8];
+                    for(int j=0;j<8;j++)
+                        r[j]=_mm256_loadu_si256((const __m256i*)(data+(size_t)(x+j)*width+(width-8-y)));
+                    transpose8x8(r);
+                    for(int i=0;i<8;i++)
+                        _mm256_storeu_si256((__m256i*)(out+(size_t)(y+7-i)*newWidth+x),r[i]);
+                }
+            }
+        }
+    }
+
+    if(xBlockEnd<newWidth)
+        rotate270Block(data,width,height,out,xBlockEnd,newWidth,yStart,yBlockEnd);
+    if(yBlockEnd<yEnd)
+        rotate270Block(data,width,height,out,0,newWidth,yBlockEnd,yEnd);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::reverseRowAvx2(const uint32_t *in, uint32_t *out, int count)
+{
+    // permutevar8x32 reverses all 8 pixels across both 128-bit lanes
+
+    int x=0;
+    for(;x+8<=count;x+=8)
+    {
+        __m256i v=_mm256_loadu_si256((const __m256i*)(in+count-8-x));
+        _mm256_storeu_si256((__m256i*)(out+x),_mm256_permutevar8x32_epi32(v,_mm256_set_epi32(0,1,2,3,4,5,6,7)));
+    }
+    if(x<count)
+        reverseRow(in,out+x,count-x);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::rotate180RowsAvx2(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowAvx2(data+(size_t)(height-1-y)*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::flipHorizontallyRowsAvx2(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowAvx2(data+(size_t)y*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::reverseRowInPlaceAvx2(uint32_t *row, int count)
+{
+    // Blocks from both ends are swapped and reversed until they would overlap
+
+    const __m256i reverse=_mm256_set_epi32(0,1,2,3,4,5,6,7);
+    int x=0;
+    for(;x+8<=count-x-8;x+=8)
+    {
+        __m256i a=_mm256_loadu_si256((const __m256i*)(row+x));
+        __m256i b=_mm256_loadu_si256((const __m256i*)(row+count-x-8));
+        _mm256_storeu_si256((__m256i*)(row+x),_mm256_permutevar8x32_epi32(b,reverse));
+        _mm256_storeu_si256((__m256i*)(row+count-x-8),_mm256_permutevar8x32_epi32(a,reverse));
+    }
+    reverseRowInPlace(row+x,count-2*x);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::reverseSwapRowsAvx2(uint32_t *a, uint32_t *b, int count)
+{
+    const __m256i reverse=_mm256_set_epi32(0,1,2,3,4,5,6,7);
+    int x=0;
+    for(;x+8<=count;x+=8)
+    {
+        __m256i va=_mm256_loadu_si256((const __m256i*)(a+x));
+        __m256i vb=_mm256_loadu_si256((const __m256i*)(b+count-x-8));
+        _mm256_storeu_si256((__m256i*)(a+x),_mm256_permutevar8x32_epi32(vb,reverse));
+        _mm256_storeu_si256((__m256i*)(b+count-x-8),_mm256_permutevar8x32_epi32(va,reverse));
+    }
+    if(x<count)
+        reverseSwapRows(a+x,b,count-x);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::flipHorizontallyInPlaceRowsAvx2(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowInPlaceAvx2(data+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX2 void RotationEngine::rotate180InPlaceRowsAvx2(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int yPos=height-1-y;
+        if(y==yPos)
+            reverseRowInPlaceAvx2(data+(size_t)y*width,width);
+        else
+            reverseSwapRowsAvx2(data+(size_t)y*width,data+(size_t)yPos*width,width);
+    }
+}
+
+#endif // ROTATIONENGINE_X86
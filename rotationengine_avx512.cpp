@@ -0,0 +1,374 @@
+#include "rotationengine.h"
+
+#ifdef ROTATIONENGINE_X86
+
+// GCC 12 warns about the self-initialized placeholder in _mm512_undefined_epi32(), which many AVX-512 intrinsics pass as
+// their unused merge source, wherever they are inlined. Compiling the file with -mavx512f does not avoid it.
+
+#if defined(__GNUC__)&&!defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__)&&!defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+// AVX-512 (F and BW) kernels processing 16 destination pixels per iteration.
+// They produce exactly the same output as their counterparts in rotationengine_scalar.cpp.
+
+// Integer parts (high dwords) or fractions (low dwords) of two vectors of eight 32.32 values, in pixel order
+
+#define hiDwords512(a,b) _mm512_permutex2var_epi32(a,_mm512_set_epi32(31,29,27,25,23,21,19,17,15,13,11,9,7,5,3,1),b)
+#define loDwords512(a,b) _mm512_permutex2var_epi32(a,_mm512_set_epi32(30,28,26,24,22,20,18,16,14,12,10,8,6,4,2,0),b)
+
+ROTATIONENGINE_TARGET_AVX512 static inline void startPositions(fixed_t p, fixed_t step, __m512i &p0, __m512i &p1)
+{
+    p0=_mm512_set_epi64(p+7*step,p+6*step,p+5*step,p+4*step,p+3*step,p+2*step,p+step,p);
+    p1=_mm512_add_epi64(p0,_mm512_set1_epi64(8*step));
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::fixedNearestNeighborInteriorRowAvx512(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    const __m512i strideV=_mm512_set1_epi32(stride);
+    const __m512i xStep16=_mm512_set1_epi64(16*xStepX);
+    const __m512i yStep16=_mm512_set1_epi64(16*xStepY);
+
+    // Rounding offset folded into the start position
+
+    __m512i x0,x1,y0,y1;
+    startPositions(x+FIXED_HALF,xStepX,x0,x1);
+    startPositions(y+FIXED_HALF,xStepY,y0,y1);
+
+    int i=0;
+    for(;i+16<=count;i+=16)
+    {
+        __m512i rX=hiDwords512(x0,x1);
+        __m512i rY=hiDwords512(y0,y1);
+        __m512i index=_mm512_add_epi32(_mm512_mullo_epi32(rY,strideV),rX);
+        _mm512_storeu_si512((void*)(out+i),_mm512_i32gather_epi32(index,(const int*)data,4));
+        x0=_mm512_add_epi64(x0,xStep16);
+        x1=_mm512_add_epi64(x1,xStep16);
+        y0=_mm512_add_epi64(y0,yStep16);
+        y1=_mm512_add_epi64(y1,yStep16);
+    }
+    if(i<count)
+        fixedNearestNeighborInteriorRowAvx2(data,width,height,stride,out+i,count-i,x+i*xStepX,y+i*xStepY,xStepX,xStepY);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::fixedBilinearInteriorRowAvx512(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    const __m512i zero=_mm512_setzero_si512();
+    const __m512i one=_mm512_set1_epi32(1);
+    const __m512i strideV=_mm512_set1_epi32(stride);
+    const __m512i weightOne=_mm512_set1_epi32(BILINEAR_WEIGHT_ONE);
+    const __m512i rounding=_mm512_set1_epi32(1<<(2*BILINEAR_WEIGHT_BITS-1));
+    const __m512i xStep16=_mm512_set1_epi64(16*xStepX);
+    const __m512i yStep16=_mm512_set1_epi64(16*xStepY);
+
+    __m512i x0,x1,y0,y1;
+    startPositions(x,xStepX,x0,x1);
+    startPositions(y,xStepY,y0,y1);
+
+    int i=0;
+    for(;i+16<=count;i+=16)
+    {
+        __m512i fX=hiDwords512(x0,x1);
+        __m512i fY=hiDwords512(y0,y1);
+        __m512i cX=_mm512_add_epi32(fX,one);
+        __m512i cY=_mm512_add_epi32(fY,one);
+
+        __m512i wX=_mm512_srli_epi32(loDwords512(x0,x1),FIXED_SHIFT-BILINEAR_WEIGHT_BITS);
+        __m512i wY=_mm512_srli_epi32(loDwords512(y0,y1),FIXED_SHIFT-BILINEAR_WEIGHT_BITS);
+
+        __m512i rowF=_mm512_mullo_epi32(fY,strideV);
+        __m512i rowC=_mm512_mullo_epi32(cY,strideV);
+        __m512i c00=_mm512_i32gather_epi32(_mm512_add_epi32(rowF,fX),(const int*)data,4);
+        __m512i c10=_mm512_i32gather_epi32(_mm512_add_epi32(rowF,cX),(const int*)data,4);
+        __m512i c01=_mm512_i32gather_epi32(_mm512_add_epi32(rowC,fX),(const int*)data,4);
+        __m512i c11=_mm512_i32gather_epi32(_mm512_add_epi32(rowC,cX),(const int*)data,4);
+
+        // Same lane layout as the AVX2 kernel, repeated in each 128-bit lane
+
+        __m512i wYPair=_mm512_or_si512(wY,_mm512_slli_epi32(wY,16));
+        __m512i wYRPair=_mm512_sub_epi16(_mm512_set1_epi16(BILINEAR_WEIGHT_ONE),wYPair);
+        __m512i wYLo=_mm512_unpacklo_epi32(wYPair,wYPair);
+        __m512i wYHi=_mm512_unpackhi_epi32(wYPair,wYPair);
+        __m512i wYRLo=_mm512_unpacklo_epi32(wYRPair,wYRPair);
+        __m512i wYRHi=_mm512_unpackhi_epi32(wYRPair,wYRPair);
+
+        __m512i leftLo=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(c00,zero),wYRLo),_mm512_mullo_epi16(_mm512_unpacklo_epi8(c01,zero),wYLo));
+        __m512i leftHi=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(c00,zero),wYRHi),_mm512_mullo_epi16(_mm512_unpackhi_epi8(c01,zero),wYHi));
+        __m512i rightLo=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(c10,zero),wYRLo),_mm512_mullo_epi16(_mm512_unpacklo_epi8(c11,zero),wYLo));
+        __m512i rightHi=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(c10,zero),wYRHi),_mm512_mullo_epi16(_mm512_unpackhi_epi8(c11,zero),wYHi));
+
+        __m512i wXPair=_mm512_or_si512(_mm512_sub_epi32(weightOne,wX),_mm512_slli_epi32(wX,16));
+        __m512i r0=_mm512_madd_epi16(_mm512_unpacklo_epi16(leftLo,rightLo),_mm512_shuffle_epi32(wXPair,_MM_PERM_AAAA));
+        __m512i r1=_mm512_madd_epi16(_mm512_unpackhi_epi16(leftLo,rightLo),_mm512_shuffle_epi32(wXPair,_MM_PERM_BBBB));
+        __m512i r2=_mm512_madd_epi16(_mm512_unpacklo_epi16(leftHi,rightHi),_mm512_shuffle_epi32(wXPair,_MM_PERM_CCCC));
+        __m512i r3=_mm512_madd_epi16(_mm512_unpackhi_epi16(leftHi,rightHi),_mm512_shuffle_epi32(wXPair,_MM_PERM_DDDD));
+        r0=_mm512_srli_epi32(_mm512_add_epi32(r0,rounding),2*BILINEAR_WEIGHT_BITS);
+        r1=_mm512_srli_epi32(_mm512_add_epi32(r1,rounding),2*BILINEAR_WEIGHT_BITS);
+        r2=_mm512_srli_epi32(_mm512_add_epi32(r2,rounding),2*BILINEAR_WEIGHT_BITS);
+        r3=_mm512_srli_epi32(_mm512_add_epi32(r3,rounding),2*BILINEAR_WEIGHT_BITS);
+
+        __m512i result=_mm512_packus_epi16(_mm512_packs_epi32(r0,r1),_mm512_packs_epi32(r2,r3));
+        _mm512_storeu_si512((void*)(out+i),result);
+        x0=_mm512_add_epi64(x0,xStep16);
+        x1=_mm512_add_epi64(x1,xStep16);
+        y0=_mm512_add_epi64(y0,yStep16);
+        y1=_mm512_add_epi64(y1,yStep16);
+    }
+    if(i<count)
+        fixedBilinearInteriorRowAvx2(data,width,height,stride,out+i,count-i,x+i*xStepX,y+i*xStepY,xStepX,xStepY);
+}
+
+// Limits the colour channels of 16 packed pixels to their alpha, as in clampToAlphaSse42()
+
+ROTATIONENGINE_TARGET_AVX512 static inline __m512i clampToAlphaAvx512(__m512i pixels)
+{
+    const __m512i alphas=_mm512_broadcast_i32x4(_mm_setr_epi8(3,3,3,3,7,7,7,7,11,11,11,11,15,15,15,15));
+    return _mm512_min_epu8(pixels,_mm512_shuffle_epi8(pixels,alphas));
+}
+
+// Four 128-bit lanes from four addresses
+
+ROTATIONENGINE_TARGET_AVX512 static inline __m512i loadLanes(const void *a, const void *b, const void *c, const void *d)
+{
+    __m512i v=_mm512_castsi128_si512(_mm_loadu_si128((const __m128i*)a));
+    v=_mm512_inserti32x4(v,_mm_loadu_si128((const __m128i*)b),1);
+    v=_mm512_inserti32x4(v,_mm_loadu_si128((const __m128i*)c),2);
+    return _mm512_inserti32x4(v,_mm_loadu_si128((const __m128i*)d),3);
+}
+
+// The four 16-bit taps at each of four addresses, in consecutive quadwords. Loaded as vectors: reading them through an int64_t
+// pointer would break strict aliasing and assume an alignment the table rows do not have.
+
+ROTATIONENGINE_TARGET_AVX512 static inline __m256i loadTaps(const int16_t *const *taps)
+{
+    __m128i lo=_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)taps[0]),_mm_loadl_epi64((const __m128i*)taps[1]));
+    __m128i hi=_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)taps[2]),_mm_loadl_epi64((const __m128i*)taps[3]));
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(lo),hi,1);
+}
+
+// Four destination pixels (one per 128-bit lane) blended as in bicubicPixelSse42(), shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_AVX512 static inline __m512i bicubicPixelsAvx512(const uint32_t *const *pixels, int stride, const int16_t *const *wX, const int16_t *const *wY)
+{
+    const int shift=2*BICUBIC_WEIGHT_BITS;
+    const __m512i pairs01=_mm512_broadcast_i32x4(_mm_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1));
+    const __m512i pairs23=_mm512_broadcast_i32x4(_mm_setr_epi8(8,-1,12,-1,9,-1,13,-1,10,-1,14,-1,11,-1,15,-1));
+
+    // The taps of pixel k go to the low quadword of lane k
+
+    __m256i wXTaps=loadTaps(wX);
+    __m512i wXV=_mm512_permutexvar_epi64(_mm512_setr_epi64(0,0,1,1,2,2,3,3),_mm512_castsi256_si512(wXTaps));
+    __m512i wX01=_mm512_shuffle_epi32(wXV,_MM_PERM_AAAA);
+    __m512i wX23=_mm512_shuffle_epi32(wXV,_MM_PERM_BBBB);
+    __m512i wYV=_mm512_cvtepi16_epi32(loadTaps(wY));
+
+    __m512i sum=_mm512_set1_epi32(1<<(shift-1));
+    for(int j=0;j<4;j++)
+    {
+        __m512i row=loadLanes(pixels[0]+j*stride,pixels[1]+j*stride,pixels[2]+j*stride,pixels[3]+j*stride);
+        __m512i h=_mm512_add_epi32(_mm512_madd_epi16(_mm512_shuffle_epi8(row,pairs01),wX01),_mm512_madd_epi16(_mm512_shuffle_epi8(row,pairs23),wX23));
+        __m512i wYj=_mm512_permutexvar_epi32(_mm512_add_epi32(_mm512_set_epi32(12,12,12,12,8,8,8,8,4,4,4,4,0,0,0,0),_mm512_set1_epi32(j)),wYV);
+        sum=_mm512_add_epi32(sum,_mm512_mullo_epi32(h,wYj));
+    }
+    return _mm512_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::fixedBicubicInteriorRowAvx512(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // Pixels stay in 128-bit lanes as in fixedBicubicInteriorRowAvx2(), 8 per iteration
+
+    const int16_t *weights=bicubicWeights();
+    const __m512i order=_mm512_setr_epi32(0,4,8,12,1,5,9,13,0,0,0,0,0,0,0,0);
+
+    int i=0;
+    for(;i+8<=count;i+=8)
+    {
+        const uint32_t *pixels[8];
+        const int16_t *wX[8],*wY[8];
+        for(int j=0;j<8;j++,x+=xStepX,y+=xStepY)
+        {
+            pixels[j]=data+(fixedToInt(y)-1)*stride+fixedToInt(x)-1;
+            wX[j]=weights+bicubicPhase(x)*4;
+            wY[j]=weights+bicubicPhase(y)*4;
+        }
+        __m512i r0=bicubicPixelsAvx512(pixels,stride,wX,wY);
+        __m512i r1=bicubicPixelsAvx512(pixels+4,stride,wX+4,wY+4);
+
+        // Lane k holds pixels k and k+4 after the per-lane packs
+
+        __m512i packed=clampToAlphaAvx512(_mm512_packus_epi16(_mm512_packs_epi32(r0,r1),_mm512_setzero_si512()));
+        __m512i result=_mm512_permutexvar_epi32(order,packed);
+        _mm256_storeu_si256((__m256i*)(out+i),_mm512_castsi512_si256(result));
+    }
+    if(i<count)
+        fixedBicubicInteriorRowAvx2(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+// Four destination pixels (one per 128-bit lane) blended as in lanczos3PixelSse42(), shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_AVX512 static inline __m512i lanczos3PixelsAvx512(const uint32_t *const *pixels, int stride, const int16_t *const *wX, const int16_t *const *wY)
+{
+    const int shift=2*LANCZOS_WEIGHT_BITS;
+    const __m512i pairs01=_mm512_broadcast_i32x4(_mm_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1));
+    const __m512i pairs23=_mm512_broadcast_i32x4(_mm_setr_epi8(8,-1,12,-1,9,-1,13,-1,10,-1,14,-1,11,-1,15,-1));
+    const __m512i laneBase=_mm512_set_epi32(12,12,12,12,8,8,8,8,4,4,4,4,0,0,0,0);
+
+    // A table row fills a lane; the vertical taps are sign-extended to 32 bits, even and odd ones separately
+
+    __m512i wXV=loadLanes(wX[0],wX[1],wX[2],wX[3]);
+    __m512i wX01=_mm512_shuffle_epi32(wXV,_MM_PERM_AAAA);
+    __m512i wX23=_mm512_shuffle_epi32(wXV,_MM_PERM_BBBB);
+    __m512i wX45=_mm512_shuffle_epi32(wXV,_MM_PERM_CCCC);
+    __m512i wYV=loadLanes(wY[0],wY[1],wY[2],wY[3]);
+    __m512i wYEven=_mm512_srai_epi32(_mm512_slli_epi32(wYV,16),16);
+    __m512i wYOdd=_mm512_srai_epi32(wYV,16);
+
+    __m512i sum=_mm512_set1_epi32(1<<(shift-1));
+    for(int j=0;j<LANCZOS_TAPS;j++)
+    {
+        __m512i row=loadLanes(pixels[0]+j*stride,pixels[1]+j*stride,pixels[2]+j*stride,pixels[3]+j*stride);
+        __m128i row45Lo=_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(pixels[0]+j*stride+4)),_mm_loadl_epi64((const __m128i*)(pixels[1]+j*stride+4)));
+        __m128i row45Hi=_mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(pixels[2]+j*stride+4)),_mm_loadl_epi64((const __m128i*)(pixels[3]+j*stride+4)));
+        __m512i row45=_mm512_castsi256_si512(_mm256_inserti128_si256(_mm256_castsi128_si256(row45Lo),row45Hi,1));
+        row45=_mm512_permutexvar_epi64(_mm512_setr_epi64(0,0,1,1,2,2,3,3),row45);
+        __m512i h=_mm512_add_epi32(_mm512_madd_epi16(_mm512_shuffle_epi8(row,pairs01),wX01),_mm512_madd_epi16(_mm512_shuffle_epi8(row,pairs23),wX23));
+        h=_mm512_add_epi32(h,_mm512_madd_epi16(_mm512_shuffle_epi8(row45,pairs01),wX45));
+        __m512i wYj=_mm512_permutexvar_epi32(_mm512_add_epi32(laneBase,_mm512_set1_epi32(j>>1)),(j&1)?wYOdd:wYEven);
+        sum=_mm512_add_epi32(sum,_mm512_mullo_epi32(h,wYj));
+    }
+    return _mm512_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::fixedLanczos3InteriorRowAvx512(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // Same layout as fixedBicubicInteriorRowAvx512()
+
+    const int16_t *weights=lanczos3Weights();
+    const __m512i order=_mm512_setr_epi32(0,4,8,12,1,5,9,13,0,0,0,0,0,0,0,0);
+
+    int i=0;
+    for(;i+8<=count;i+=8)
+    {
+        const uint32_t *pixels[8];
+        const int16_t *wX[8],*wY[8];
+        for(int j=0;j<8;j++,x+=xStepX,y+=xStepY)
+        {
+            pixels[j]=data+(fixedToInt(y)-2)*stride+fixedToInt(x)-2;
+            wX[j]=weights+lanczosPhase(x)*LANCZOS_TABLE_STRIDE;
+            wY[j]=weights+lanczosPhase(y)*LANCZOS_TABLE_STRIDE;
+        }
+        __m512i r0=lanczos3PixelsAvx512(pixels,stride,wX,wY);
+        __m512i r1=lanczos3PixelsAvx512(pixels+4,stride,wX+4,wY+4);
+
+        __m512i packed=clampToAlphaAvx512(_mm512_packus_epi16(_mm512_packs_epi32(r0,r1),_mm512_setzero_si512()));
+        __m512i result=_mm512_permutexvar_epi32(order,packed);
+        _mm256_storeu_si256((__m256i*)(out+i),_mm512_castsi512_si256(result));
+    }
+    if(i<count)
+        fixedLanczos3InteriorRowAvx2(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::shearRowAvx512(const uint32_t *in, uint32_t *out, int count, uint32_t weight)
+{
+    const __m512i zero=_mm512_setzero_si512();
+    const __m512i weightV=_mm512_set1_epi16(weight);
+    const __m512i weightRV=_mm512_set1_epi16(BILINEAR_WEIGHT_ONE-weight);
+    const __m512i rounding=_mm512_set1_epi16(1<<(BILINEAR_WEIGHT_BITS-1));
+
+    int i=0;
+    for(;i+16<=count;i+=16)
+    {
+        __m512i c0=_mm512_loadu_si512((const void*)(in+i));
+        __m512i c1=_mm512_loadu_si512((const void*)(in+i+1));
+        __m512i lo=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpacklo_epi8(c0,zero),weightRV),_mm512_mullo_epi16(_mm512_unpacklo_epi8(c1,zero),weightV));
+        __m512i hi=_mm512_add_epi16(_mm512_mullo_epi16(_mm512_unpackhi_epi8(c0,zero),weightRV),_mm512_mullo_epi16(_mm512_unpackhi_epi8(c1,zero),weightV));
+        lo=_mm512_srli_epi16(_mm512_add_epi16(lo,rounding),BILINEAR_WEIGHT_BITS);
+        hi=_mm512_srli_epi16(_mm512_add_epi16(hi,rounding),BILINEAR_WEIGHT_BITS);
+        _mm512_storeu_si512((void*)(out+i),_mm512_packus_epi16(lo,hi));
+    }
+    if(i<count)
+        shearRowAvx2(in+i,out+i,count-i,weight);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::reverseRowAvx512(const uint32_t *in, uint32_t *out, int count)
+{
+    int x=0;
+    for(;x+16<=count;x+=16)
+    {
+        __m512i v=_mm512_loadu_si512((const void*)(in+count-16-x));
+        _mm512_storeu_si512((void*)(out+x),_mm512_permutexvar_epi32(_mm512_set_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15),v));
+    }
+    if(x<count)
+        reverseRow(in,out+x,count-x);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::rotate180RowsAvx512(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowAvx512(data+(size_t)(height-1-y)*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::flipHorizontallyRowsAvx512(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowAvx512(data+(size_t)y*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::reverseRowInPlaceAvx512(uint32_t *row, int count)
+{
+    // Blocks from both ends are swapped and reversed until they would overlap
+
+    const __m512i reverse=_mm512_set_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+    int x=0;
+    for(;x+16<=count-x-16;x+=16)
+    {
+        __m512i a=_mm512_loadu_si512((const void*)(row+x));
+        __m512i b=_mm512_loadu_si512((const void*)(row+count-x-16));
+        _mm512_storeu_si512((void*)(row+x),_mm512_permutexvar_epi32(reverse,b));
+        _mm512_storeu_si512((void*)(row+count-x-16),_mm512_permutexvar_epi32(reverse,a));
+    }
+    reverseRowInPlace(row+x,count-2*x);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::reverseSwapRowsAvx512(uint32_t *a, uint32_t *b, int count)
+{
+    const __m512i reverse=_mm512_set_epi32(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+    int x=0;
+    for(;x+16<=count;x+=16)
+    {
+        __m512i va=_mm512_loadu_si512((const void*)(a+x));
+        __m512i vb=_mm512_loadu_si512((const void*)(b+count-x-16));
+        _mm512_storeu_si512((void*)(a+x),_mm512_permutexvar_epi32(reverse,vb));
+        _mm512_storeu_si512((void*)(b+count-x-16),_mm512_permutexvar_epi32(reverse,va));
+    }
+    if(x<count)
+        reverseSwapRows(a+x,b,count-x);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::flipHorizontallyInPlaceRowsAvx512(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowInPlaceAvx512(data+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_AVX512 void RotationEngine::rotate180InPlaceRowsAvx512(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int yPos=height-1-y;
+        if(y==yPos)
+            reverseRowInPlaceAvx512(data+(size_t)y*width,width);
+        else
+            reverseSwapRowsAvx512(data+(size_t)y*width,data+(size_t)yPos*width,width);
+    }
+}
+
+#endif // ROTATIONENGINE_X86
@@ -0,0 +1,750 @@
+#include "rotationengine.h"
+
+// Portable implementations of all kernels. SIMD kernels must produce exactly the same output.
+
+// The resampling row kernels are instantiated from one template per precision, for each method and bounds policy.
+// The InteriorOnly instances are straight loops for the interior of a span, where resample() guarantees that every neighbour exists;
+// the others map neighbours beyond the edges back into the source in the same pass.
+
+// Bounds policies. index() maps a pixel index that may lie outside [0,size) to one inside; SkipOutside instances leave pixels whose
+// rounded coordinate lies outside the source untouched.
+
+struct InteriorOnly
+{
+    enum { checks=0, skipsOutside=0 };
+    static inline int index(int i, int size) { (void)size; return i; }
+};
+
+struct SkipOutside
+{
+    enum { checks=1, skipsOutside=1 };
+    static inline int index(int i, int size) { return __max(__min(i,size-1),0); }
+};
+
+struct ClampToEdge
+{
+    enum { checks=1, skipsOutside=0 };
+    static inline int index(int i, int size) { return __max(__min(i,size-1),0); }
+};
+
+struct MirrorAtEdges
+{
+    enum { checks=1, skipsOutside=0 };
+    static inline int index(int i, int size)
+    {
+        // Reflection about the outer pixel edges, so that the edge pixels repeat once: ..., 1, 0, 0, 1, ..., size-1, size-1, ...
+
+        int period=2*size;
+        int m=i%period;
+        if(m<0)
+            m+=period;
+        return m<size?m:period-1-m;
+    }
+};
+
+struct WrapAround
+{
+    enum { checks=1, skipsOutside=0 };
+    static inline int index(int i, int size)
+    {
+        int m=i%size;
+        return m<0?m+size:m;
+    }
+};
+
+// Bilinear blend of four source pixels; (origX,origY) lies between them
+
+static inline uint32_t doubleBilinearBlend(uint32_t c00, uint32_t c10, uint32_t c01, uint32_t c11, decimal_t origX, decimal_t origY)
+{
+    decimal_t xDiff=origX-floor(origX);
+    decimal_t xDiffR=1.0-xDiff;
+    decimal_t yDiff=origY-floor(origY);
+    decimal_t yDiffR=1.0-yDiff;
+
+    decimal_t w1=xDiffR*yDiffR;
+    decimal_t w2=xDiff*yDiffR;
+    decimal_t w3=xDiffR*yDiff;
+    decimal_t w4=xDiff*yDiff;
+
+    uint32_t newAlpha=RotationEngine::bilinearInterpolate(getAlpha(c00),getAlpha(c01),getAlpha(c10),getAlpha(c11),w1,w2,w3,w4);
+    uint32_t newRed=RotationEngine::bilinearInterpolate(getRed(c00),getRed(c01),getRed(c10),getRed(c11),w1,w2,w3,w4);
+    uint32_t newGreen=RotationEngine::bilinearInterpolate(getGreen(c00),getGreen(c01),getGreen(c10),getGreen(c11),w1,w2,w3,w4);
+    uint32_t newBlue=RotationEngine::bilinearInterpolate(getBlue(c00),getBlue(c01),getBlue(c10),getBlue(c11),w1,w2,w3,w4);
+
+    return getColor(newAlpha,newRed,newGreen,newBlue);
+}
+
+template<bool bilinear,class Border>
+static inline void doubleRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int first, int count, decimal_t x, decimal_t y, decimal_t xStepX, decimal_t xStepY)
+{
+    for(int i=0;i<count;i++)
+    {
+        decimal_t origX=x+(first+i)*xStepX;
+        decimal_t origY=y+(first+i)*xStepY;
+        if(Border::skipsOutside||!bilinear)
+        {
+            // Round at the last step
+
+            int rOrigX=round(origX);
+            int rOrigY=round(origY);
+
+            // Check whether point exists
+
+            if(Border::skipsOutside&&(rOrigX<0||rOrigX>=width||rOrigY<0||rOrigY>=height))
+                continue;
+
+            if(!bilinear)
+            {
+                out[i]=data[Border::index(rOrigY,height)*stride+Border::index(rOrigX,width)];
+                continue;
+            }
+        }
+
+        int fOrigX=Border::index((int)floor(origX),width);
+        int fOrigY=Border::index((int)floor(origY),height);
+        int cOrigX=Border::index((int)ceil(origX),width);
+        int cOrigY=Border::index((int)ceil(origY),height);
+
+        uint32_t c00=data[fOrigY*stride+fOrigX];
+        uint32_t c10=data[fOrigY*stride+cOrigX];
+        uint32_t c01=data[cOrigY*stride+fOrigX];
+        uint32_t c11=data[cOrigY*stride+cOrigX];
+
+        out[i]=doubleBilinearBlend(c00,c10,c01,c11,origX,origY);
+    }
+}
+
+void RotationEngine::doubleNearestNeighborRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int first, int count, decimal_t x, decimal_t y, decimal_t xStepX, decimal_t xStepY)
+{
+    doubleRow<false,SkipOutside>(data,width,height,stride,out,first,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::doubleBilinearRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int first, int count, decimal_t x, decimal_t y, decimal_t xStepX, decimal_t xStepY)
+{
+    doubleRow<true,SkipOutside>(data,width,height,stride,out,first,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::doubleNearestNeighborInteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int first, int count, decimal_t x, decimal_t y, decimal_t xStepX, decimal_t xStepY)
+{
+    doubleRow<false,InteriorOnly>(data,width,height,stride,out,first,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::doubleBilinearInteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int first, int count, decimal_t x, decimal_t y, decimal_t xStepX, decimal_t xStepY)
+{
+    doubleRow<true,InteriorOnly>(data,width,height,stride,out,first,count,x,y,xStepX,xStepY);
+}
+
+// Vertical blend first (fits into 16 bits per channel), then horizontal blend (needs 32 bits), rounded once at the end.
+// The SIMD kernels perform exactly the same operations, so all implementations produce identical results.
+
+static inline uint32_t fixedBilinearBlend(uint32_t c00, uint32_t c10, uint32_t c01, uint32_t c11, uint32_t wX, uint32_t wY)
+{
+    const int shift=2*BILINEAR_WEIGHT_BITS;
+    const uint32_t rounding=1<<(shift-1);
+    uint32_t wXR=BILINEAR_WEIGHT_ONE-wX;
+    uint32_t wYR=BILINEAR_WEIGHT_ONE-wY;
+
+    uint32_t result=0;
+    for(int byte=0;byte<4;byte++)
+    {
+        uint32_t left=getByte(c00,byte)*wYR+getByte(c01,byte)*wY;
+        uint32_t right=getByte(c10,byte)*wYR+getByte(c11,byte)*wY;
+        result|=((left*wXR+right*wX+rounding)>>shift)<<(byte*8);
+    }
+    return result;
+}
+
+// Catmull-Rom taps for pixels -1..2 around fractional position t=phase/BICUBIC_PHASES. The cubics are evaluated exactly in integers,
+// rounded, and corrected on the largest tap so that every row sums to BICUBIC_WEIGHT_ONE and flat areas stay flat.
+
+static bool buildBicubicWeights(int16_t *table)
+{
+    const int64_t n=BICUBIC_PHASES;
+    const int64_t denominator=2*n*n*n;
+    for(int64_t p=0;p<n;p++)
+    {
+        int64_t numerators[4]=
+        {
+            -p*p*p+2*p*p*n-p*n*n,
+            3*p*p*p-5*p*p*n+2*n*n*n,
+            -3*p*p*p+4*p*p*n+p*n*n,
+            p*p*p-p*p*n
+        };
+        int16_t *weights=table+p*4;
+        int sum=0;
+        for(int i=0;i<4;i++)
+        {
+            // Round to nearest; numerators may be negative
+
+            int64_t scaled=2*numerators[i]*BICUBIC_WEIGHT_ONE+denominator;
+            int64_t q=scaled/(2*denominator);
+            if(scaled%(2*denominator)!=0&&scaled<0)
+                q--;
+            weights[i]=(int16_t)q;
+            sum+=weights[i];
+        }
+        weights[p*2<n?1:2]+=BICUBIC_WEIGHT_ONE-sum;
+    }
+    return true;
+}
+
+const int16_t *RotationEngine::bicubicWeights()
+{
+    static int16_t table[BICUBIC_PHASES*4];
+    static bool built=buildBicubicWeights(table);
+    (void)built;
+    return table;
+}
+
+// Pixels are premultiplied, so no colour channel may exceed alpha; negative lobes of the wider kernels can break that, and it is restored
+// after clamping to [0,255]
+
+static inline uint32_t clampToAlpha(uint32_t color)
+{
+    uint32_t alpha=getAlpha(color);
+    return getColor(alpha,__min(getRed(color),alpha),__min(getGreen(color),alpha),__min(getBlue(color),alpha));
+}
+
+// Separable 4x4 blend: each source row is blended horizontally in 32 bits, then the four results vertically, rounded once at the end.
+// Overshoot of the spline is clamped. The SIMD kernels perform exactly the same operations.
+
+static inline uint32_t fixedBicubicBlend(const uint32_t *pixels, int stride, const int16_t *wX, const int16_t *wY)
+{
+    const int shift=2*BICUBIC_WEIGHT_BITS;
+    const int32_t rounding=1<<(shift-1);
+
+    uint32_t result=0;
+    for(int byte=0;byte<4;byte++)
+    {
+        int32_t sum=rounding;
+        for(int j=0;j<4;j++)
+        {
+            const uint32_t *row=pixels+j*stride;
+            int32_t h=0;
+            for(int i=0;i<4;i++)
+                h+=wX[i]*(int32_t)getByte(row[i],byte);
+            sum+=wY[j]*h;
+        }
+        uint32_t value=sum<0?0:__min(sum>>shift,255);
+        result|=value<<(byte*8);
+    }
+    return clampToAlpha(result);
+}
+
+// Lanczos-3 taps for pixels -2..3 around fractional position t=phase/LANCZOS_PHASES: 3*sin(pi*x)*sin(pi*x/3)/(pi*x)^2 at x=i-2-t,
+// normalized to sum to one, rounded, and corrected on the largest tap so that every row sums to LANCZOS_WEIGHT_ONE. The taps are
+// tabulated rather than computed with libm, whose sin() may round differently on other platforms, so that the output is the same
+// everywhere. Rows are padded with zeros to LANCZOS_TABLE_STRIDE taps.
+
+static const int16_t lanczos3Table[LANCZOS_PHASES][LANCZOS_TABLE_STRIDE]=
+{
+    {0,0,1024,0,0,0,0,0},
+    {2,-7,1024,7,-2,0,0,0},
+    {3,-13,1023,14,-3,0,0,0},
+    {5,-19,1023,20,-5,0,0,0},
+    {6,-25,1022,28,-7,0,0,0},
+    {8,-31,1021,35,-9,0,0,0},
+    {9,-37,1021,42,-11,0,0,0},
+    {11,-43,1019,50,-13,0,0,0},
+    {12,-48,1018,57,-15,0,0,0},
+    {13,-54,1015,65,-16,1,0,0},
+    {14,-59,1014,73,-19,1,0,0},
+    {16,-64,1011,81,-21,1,0,0},
+    {17,-69,1009,89,-23,1,0,0},
+    {18,-74,1006,98,-25,1,0,0},
+    {19,-78,1003,106,-27,1,0,0},
+    {20,-83,999,115,-29,2,0,0},
+    {21,-87,995,124,-31,2,0,0},
+    {22,-91,993,132,-34,2,0,0},
+    {23,-95,989,141,-36,2,0,0},
+    {24,-99,984,150,-38,3,0,0},
+    {24,-103,980,160,-40,3,0,0},
+    {25,-106,976,169,-43,3,0,0},
+    {26,-110,971,178,-45,4,0,0},
+    {27,-113,966,188,-48,4,0,0},
+    {27,-116,962,197,-50,4,0,0},
+    {28,-119,955,207,-52,5,0,0},
+    {28,-122,951,217,-55,5,0,0},
+    {29,-125,945,227,-57,5,0,0},
+    {29,-128,940,237,-60,6,0,0},
+    {30,-130,933,247,-62,6,0,0},
+    {30,-132,927,257,-65,7,0,0},
+    {31,-134,920,267,-67,7,0,0},
+    {31,-136,913,278,-70,8,0,0},
+    {31,-138,907,288,-72,8,0,0},
+    {31,-140,902,298,-75,8,0,0},
+    {32,-142,893,309,-77,9,0,0},
+    {32,-143,886,320,-80,9,0,0},
+    {32,-145,879,330,-82,10,0,0},
+    {32,-146,871,341,-85,11,0,0},
+    {32,-147,863,352,-87,11,0,0},
+    {32,-148,855,363,-90,12,0,0},
+    {32,-149,848,373,-92,12,0,0},
+    {32,-150,839,384,-94,13,0,0},
+    {32,-150,831,395,-97,13,0,0},
+    {32,-151,822,406,-99,14,0,0},
+    {32,-151,814,417,-102,14,0,0},
+    {32,-151,804,428,-104,15,0,0},
+    {31,-151,796,439,-106,15,0,0},
+    {31,-152,788,450,-109,16,0,0},
+    {31,-151,777,461,-111,17,0,0},
+    {31,-151,767,473,-113,17,0,0},
+    {30,-151,758,484,-115,18,0,0},
+    {30,-151,749,495,-117,18,0,0},
+    {30,-150,738,506,-119,19,0,0},
+    {29,-150,729,517,-121,20,0,0},
+    {29,-149,719,528,-123,20,0,0},
+    {29,-148,708,539,-125,21,0,0},
+    {28,-147,699,550,-127,21,0,0},
+    {28,-146,688,561,-129,22,0,0},
+    {27,-145,679,572,-131,22,0,0},
+    {27,-144,668,583,-133,23,0,0},
+    {27,-143,657,594,-134,23,0,0},
+    {26,-142,647,605,-136,24,0,0},
+    {26,-141,637,615,-138,25,0,0},
+    {25,-139,626,626,-139,25,0,0},
+    {25,-138,615,637,-141,26,0,0},
+    {24,-136,605,647,-142,26,0,0},
+    {23,-134,594,657,-143,27,0,0},
+    {23,-133,583,668,-144,27,0,0},
+    {22,-131,572,679,-145,27,0,0},
+    {22,-129,561,688,-146,28,0,0},
+    {21,-127,550,699,-147,28,0,0},
+    {21,-125,539,708,-148,29,0,0},
+    {20,-123,528,719,-149,29,0,0},
+    {20,-121,517,729,-150,29,0,0},
+    {19,-119,506,738,-150,30,0,0},
+    {18,-117,495,749,-151,30,0,0},
+    {18,-115,484,758,-151,30,0,0},
+    {17,-113,473,767,-151,31,0,0},
+    {17,-111,461,777,-151,31,0,0},
+    {16,-109,450,788,-152,31,0,0},
+    {15,-106,439,796,-151,31,0,0},
+    {15,-104,428,804,-151,32,0,0},
+    {14,-102,417,814,-151,32,0,0},
+    {14,-99,406,822,-151,32,0,0},
+    {13,-97,395,831,-150,32,0,0},
+    {13,-94,384,839,-150,32,0,0},
+    {12,-92,373,848,-149,32,0,0},
+    {12,-90,363,855,-148,32,0,0},
+    {11,-87,352,863,-147,32,0,0},
+    {11,-85,341,871,-146,32,0,0},
+    {10,-82,330,879,-145,32,0,0},
+    {9,-80,320,886,-143,32,0,0},
+    {9,-77,309,893,-142,32,0,0},
+    {8,-75,298,902,-140,31,0,0},
+    {8,-72,288,907,-138,31,0,0},
+    {8,-70,278,913,-136,31,0,0},
+    {7,-67,267,920,-134,31,0,0},
+    {7,-65,257,927,-132,30,0,0},
+    {6,-62,247,933,-130,30,0,0},
+    {6,-60,237,940,-128,29,0,0},
+    {5,-57,227,945,-125,29,0,0},
+    {5,-55,217,951,-122,28,0,0},
+    {5,-52,207,955,-119,28,0,0},
+    {4,-50,197,962,-116,27,0,0},
+    {4,-48,188,966,-113,27,0,0},
+    {4,-45,178,971,-110,26,0,0},
+    {3,-43,169,976,-106,25,0,0},
+    {3,-40,160,980,-103,24,0,0},
+    {3,-38,150,984,-99,24,0,0},
+    {2,-36,141,989,-95,23,0,0},
+    {2,-34,132,993,-91,22,0,0},
+    {2,-31,124,995,-87,21,0,0},
+    {2,-29,115,999,-83,20,0,0},
+    {1,-27,106,1003,-78,19,0,0},
+    {1,-25,98,1006,-74,18,0,0},
+    {1,-23,89,1009,-69,17,0,0},
+    {1,-21,81,1011,-64,16,0,0},
+    {1,-19,73,1014,-59,14,0,0},
+    {1,-16,65,1015,-54,13,0,0},
+    {0,-15,57,1018,-48,12,0,0},
+    {0,-13,50,1019,-43,11,0,0},
+    {0,-11,42,1021,-37,9,0,0},
+    {0,-9,35,1021,-31,8,0,0},
+    {0,-7,28,1022,-25,6,0,0},
+    {0,-5,20,1023,-19,5,0,0},
+    {0,-3,14,1023,-13,3,0,0},
+    {0,-2,7,1024,-7,2,0,0}
+};
+
+const int16_t *RotationEngine::lanczos3Weights()
+{
+    return lanczos3Table[0];
+}
+
+// Separable 6x6 blend, with the same order of operations as fixedBicubicBlend()
+
+static inline uint32_t fixedLanczos3Blend(const uint32_t *pixels, int stride, const int16_t *wX, const int16_t *wY)
+{
+    const int shift=2*LANCZOS_WEIGHT_BITS;
+    const int32_t rounding=1<<(shift-1);
+
+    uint32_t result=0;
+    for(int byte=0;byte<4;byte++)
+    {
+        int32_t sum=rounding;
+        for(int j=0;j<LANCZOS_TAPS;j++)
+        {
+            const uint32_t *row=pixels+j*stride;
+            int32_t h=0;
+            for(int i=0;i<LANCZOS_TAPS;i++)
+                h+=wX[i]*(int32_t)getByte(row[i],byte);
+            sum+=wY[j]*h;
+        }
+        uint32_t value=sum<0?0:__min(sum>>shift,255);
+        result|=value<<(byte*8);
+    }
+    return clampToAlpha(result);
+}
+
+// Sampling rules of the fixed-point methods. The pixel at the truncated coordinate (after adding offset()) is preceded by "before"
+// neighbours in each direction, and sample() blends the taps*taps block starting there; stride separates its rows.
+
+struct FixedNearestNeighbor
+{
+    enum { taps=1, before=0 };
+    static inline fixed_t offset() { return FIXED_HALF; }
+    static inline const int16_t *weights() { return 0; }
+    static inline uint32_t sample(const uint32_t *pixels, int stride, fixed_t x, fixed_t y, const int16_t *weights)
+    {
+        (void)stride; (void)x; (void)y; (void)weights;
+        return pixels[0];
+    }
+};
+
+struct FixedBilinear
+{
+    enum { taps=2, before=0 };
+    static inline fixed_t offset() { return 0; }
+    static inline const int16_t *weights() { return 0; }
+    static inline uint32_t sample(const uint32_t *pixels, int stride, fixed_t x, fixed_t y, const int16_t *weights)
+    {
+        (void)weights;
+        return fixedBilinearBlend(pixels[0],pixels[1],pixels[stride],pixels[stride+1],bilinearWeight(x),bilinearWeight(y));
+    }
+};
+
+struct FixedBicubic
+{
+    enum { taps=4, before=1 };
+    static inline fixed_t offset() { return 0; }
+    static inline const int16_t *weights() { return RotationEngine::bicubicWeights(); }
+    static inline uint32_t sample(const uint32_t *pixels, int stride, fixed_t x, fixed_t y, const int16_t *weights)
+    {
+        return fixedBicubicBlend(pixels,stride,weights+bicubicPhase(x)*4,weights+bicubicPhase(y)*4);
+    }
+};
+
+struct FixedLanczos3
+{
+    enum { taps=LANCZOS_TAPS, before=2 };
+    static inline fixed_t offset() { return 0; }
+    static inline const int16_t *weights() { return RotationEngine::lanczos3Weights(); }
+    static inline uint32_t sample(const uint32_t *pixels, int stride, fixed_t x, fixed_t y, const int16_t *weights)
+    {
+        return fixedLanczos3Blend(pixels,stride,weights+lanczosPhase(x)*LANCZOS_TABLE_STRIDE,weights+lanczosPhase(y)*LANCZOS_TABLE_STRIDE);
+    }
+};
+
+template<class Method,class Border>
+static inline void fixedRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    const int16_t *weights=Method::weights();
+
+    for(int i=0;i<count;i++,x+=xStepX,y+=xStepY)
+    {
+        int32_t fX=fixedToInt(x+Method::offset())-Method::before;
+        int32_t fY=fixedToInt(y+Method::offset())-Method::before;
+        if(!Border::checks)
+        {
+            out[i]=Method::sample(data+fY*stride+fX,stride,x,y,weights);
+            continue;
+        }
+
+        // Unsigned comparison also rejects negative coordinates
+
+        int32_t rX=fixedToInt(x+FIXED_HALF);
+        int32_t rY=fixedToInt(y+FIXED_HALF);
+        if(Border::skipsOutside&&((uint32_t)rX>=(uint32_t)width||(uint32_t)rY>=(uint32_t)height))
+            continue;
+
+        uint32_t pixels[Method::taps*Method::taps];
+        for(int j=0;j<Method::taps;j++)
+        {
+            const uint32_t *row=data+Border::index(fY+j,height)*stride;
+            for(int k=0;k<Method::taps;k++)
+                pixels[j*Method::taps+k]=row[Border::index(fX+k,width)];
+        }
+        out[i]=Method::sample(pixels,Method::taps,x,y,weights);
+    }
+}
+
+void RotationEngine::fixedNearestNeighborRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedNearestNeighbor,SkipOutside>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedNearestNeighborInteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedNearestNeighbor,InteriorOnly>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedBilinearRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedBilinear,SkipOutside>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedBilinearInteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedBilinear,InteriorOnly>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedBicubicRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedBicubic,SkipOutside>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedBicubicInteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedBicubic,InteriorOnly>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedLanczos3Row(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedLanczos3,SkipOutside>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+void RotationEngine::fixedLanczos3InteriorRow(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    fixedRow<FixedLanczos3,InteriorOnly>(data,width,height,stride,out,count,x,y,xStepX,xStepY);
+}
+
+// Checking kernels for every method and border mode; 0 for methods or precisions without row kernels. Transparent and constant
+// borders share the kernels that skip pixels outside the source, which resample() fills.
+
+#define EDGE_ROWS(row,kind) {row<kind,SkipOutside>,row<kind,SkipOutside>,row<kind,ClampToEdge>,row<kind,MirrorAtEdges>,row<kind,WrapAround>}
+
+ResampleRowFunc RotationEngine::fixedEdgeRow(int method, int border)
+{
+    static const ResampleRowFunc rows[METHOD_COUNT][BORDER_MODE_COUNT]=
+    {
+        EDGE_ROWS(fixedRow,FixedNearestNeighbor),
+        EDGE_ROWS(fixedRow,FixedBilinear),
+        {0,0,0,0,0}, // ThreeShear
+        EDGE_ROWS(fixedRow,FixedBicubic),
+        EDGE_ROWS(fixedRow,FixedLanczos3)
+    };
+    if(method<0||method>=METHOD_COUNT||border<0||border>=BORDER_MODE_COUNT)
+        return 0;
+    return rows[method][border];
+}
+
+DoubleRowFunc RotationEngine::doubleEdgeRow(int method, int border)
+{
+    static const DoubleRowFunc rows[2][BORDER_MODE_COUNT]=
+    {
+        EDGE_ROWS(doubleRow,false),
+        EDGE_ROWS(doubleRow,true)
+    };
+    if((method!=NearestNeighbor&&method!=Bilinear)||border<0||border>=BORDER_MODE_COUNT)
+        return 0;
+    return rows[method==Bilinear][border];
+}
+
+void RotationEngine::shearRow(const uint32_t *in, uint32_t *out, int count, uint32_t weight)
+{
+    // Same rounding as the bilinear kernels, in one dimension
+
+    const uint32_t rounding=1<<(BILINEAR_WEIGHT_BITS-1);
+    uint32_t weightR=BILINEAR_WEIGHT_ONE-weight;
+    for(int i=0;i<count;i++)
+    {
+        uint32_t c0=in[i];
+        uint32_t c1=in[i+1];
+        uint32_t result=0;
+        for(int byte=0;byte<4;byte++)
+            result|=((getByte(c0,byte)*weightR+getByte(c1,byte)*weight+rounding)>>BILINEAR_WEIGHT_BITS)<<(byte*8);
+        out[i]=result;
+    }
+}
+
+void RotationEngine::transposeBlock(const uint32_t *in, int inStride, uint32_t *out, int outStride, int width, int height)
+{
+    for(int x=0;x<width;x++)
+    {
+        for(int y=0;y<height;y++)
+            out[(size_t)x*outStride+y]=in[(size_t)y*inStride+x];
+    }
+}
+
+void RotationEngine::rotate90Block(const uint32_t *data, int width, int height, uint32_t *out, int xStart, int xEnd, int yStart, int yEnd)
+{
+    // Flip to right; the destination is height*width
+
+    int newWidth=height;
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int offset=y*newWidth;
+        int currentX=height-xStart;
+        for(int x=xStart;x<xEnd;x++)
+        {
+            currentX--;
+            out[offset+x]=data[currentX*width+y];
+        }
+    }
+}
+
+void RotationEngine::rotate90Rows(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Tiles keep the source columns being read in the cache
+
+    int newWidth=height;
+    for(int tileY=yStart;tileY<yEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        for(int tileX=0;tileX<newWidth;tileX+=TRANSPOSE_TILE_SIZE)
+            rotate90Block(data,width,height,out,tileX,__min(tileX+TRANSPOSE_TILE_SIZE,newWidth),tileY,__min(tileY+TRANSPOSE_TILE_SIZE,yEnd));
+    }
+}
+
+void RotationEngine::reverseRow(const uint32_t *in, uint32_t *out, int count)
+{
+    int xPos=count;
+    for(int x=0;x<count;x++)
+    {
+        xPos--;
+        out[x]=in[xPos];
+    }
+}
+
+void RotationEngine::rotate180Rows(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Not the same as flipping vertically
+
+    for(int y=yStart;y<yEnd;y++)
+        reverseRow(data+(size_t)(height-1-y)*width,out+(size_t)y*width,width);
+}
+
+void RotationEngine::rotate270Block(const uint32_t *data, int width, int height, uint32_t *out, int xStart, int xEnd, int yStart, int yEnd)
+{
+    // Flip to left; the destination is height*width
+
+    int newWidth=height;
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int offset=y*newWidth;
+        int origX=width-1-y;
+        for(int x=xStart;x<xEnd;x++)
+            out[offset+x]=data[x*width+origX];
+    }
+}
+
+void RotationEngine::rotate270Rows(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    int newWidth=height;
+    for(int tileY=yStart;tileY<yEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        for(int tileX=0;tileX<newWidth;tileX+=TRANSPOSE_TILE_SIZE)
+            rotate270Block(data,width,height,out,tileX,__min(tileX+TRANSPOSE_TILE_SIZE,newWidth),tileY,__min(tileY+TRANSPOSE_TILE_SIZE,yEnd));
+    }
+}
+
+void RotationEngine::flipVerticallyRows(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Rows stay intact, so this is a plain copy of each row
+
+    for(int y=yStart;y<yEnd;y++)
+        memcpy(out+(size_t)y*width,data+(size_t)(height-1-y)*width,width*sizeof(uint32_t));
+}
+
+void RotationEngine::flipHorizontallyRows(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRow(data+(size_t)y*width,out+(size_t)y*width,width);
+}
+
+void RotationEngine::reverseRowInPlace(uint32_t *row, int count)
+{
+    for(int x=0,xPos=count-1;x<xPos;x++,xPos--)
+    {
+        uint32_t pixel=row[x];
+        row[x]=row[xPos];
+        row[xPos]=pixel;
+    }
+}
+
+void RotationEngine::reverseSwapRows(uint32_t *a, uint32_t *b, int count)
+{
+    // a becomes b reversed and vice versa
+
+    for(int x=0,xPos=count-1;x<count;x++,xPos--)
+    {
+        uint32_t pixel=a[x];
+        a[x]=b[xPos];
+        b[xPos]=pixel;
+    }
+}
+
+void RotationEngine::flipVerticallyInPlaceRows(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    // Swaps row y with row height-1-y for y in [yStart,yEnd), yEnd<=height/2, through a fixed-size buffer
+
+    uint32_t buffer[IN_PLACE_CHUNK_SIZE];
+    for(int y=yStart;y<yEnd;y++)
+    {
+        uint32_t *a=data+(size_t)y*width;
+        uint32_t *b=data+(size_t)(height-1-y)*width;
+        for(int x=0;x<width;x+=IN_PLACE_CHUNK_SIZE)
+        {
+            size_t bytes=__min(IN_PLACE_CHUNK_SIZE,width-x)*sizeof(uint32_t);
+            memcpy(buffer,a+x,bytes);
+            memcpy(a+x,b+x,bytes);
+            memcpy(b+x,buffer,bytes);
+        }
+    }
+}
+
+void RotationEngine::flipHorizontallyInPlaceRows(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowInPlace(data+(size_t)y*width,width);
+}
+
+void RotationEngine::rotate180InPlaceRows(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    // Row y and row height-1-y swap places and are reversed, for y in [yStart,yEnd), yEnd<=(height+1)/2.
+    // The middle row of an image with an odd height is only reversed.
+
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int yPos=height-1-y;
+        if(y==yPos)
+            reverseRowInPlace(data+(size_t)y*width,width);
+        else
+            reverseSwapRows(data+(size_t)y*width,data+(size_t)yPos*width,width);
+    }
+}
+
+void RotationEngine::convertScanLineRows(const uint8_t *bits, int bytesPerLine, int width, uint32_t *out, int yStart, int yEnd)
+{
+    // 0xAARRGGBB scan lines already have the engine's layout; only the padding at the end of each line has to be dropped
+
+    for(int y=yStart;y<yEnd;y++)
+        memcpy(out+(size_t)y*width,bits+(size_t)y*bytesPerLine,width*sizeof(uint32_t));
+}
+
+void RotationEngine::halveRow(const uint32_t *in, int stride, uint32_t *out, int count)
+{
+    // Red and blue, then alpha and green, are summed as pairs of 16-bit lanes, which hold four 8-bit values and the rounding term
+
+    const uint32_t *in2=in+stride;
+    for(int i=0;i<count;i++)
+    {
+        uint32_t p00=in[2*i],p10=in[2*i+1],p01=in2[2*i],p11=in2[2*i+1];
+        uint32_t rb=(p00&0x00ff00ff)+(p10&0x00ff00ff)+(p01&0x00ff00ff)+(p11&0x00ff00ff)+0x00020002;
+        uint32_t ag=((p00>>8)&0x00ff00ff)+((p10>>8)&0x00ff00ff)+((p01>>8)&0x00ff00ff)+((p11>>8)&0x00ff00ff)+0x00020002;
+        out[i]=((rb>>2)&0x00ff00ff)|(((ag>>2)&0x00ff00ff)<<8);
+    }
+}
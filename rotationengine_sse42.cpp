@@ -0,0 +1,397 @@
+#include "rotationengine.h"
+
+#ifdef ROTATIONENGINE_X86
+
+#include <immintrin.h>
+
+// SSE4.2 kernels processing 4 destination pixels per iteration.
+// They produce exactly the same output as their counterparts in rotationengine_scalar.cpp.
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::fixedBilinearInteriorRowSse42(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // There are no gathers below AVX2, so coordinates are computed per pixel; only the blend is vectorized.
+
+    const __m128i zero=_mm_setzero_si128();
+    const __m128i rounding=_mm_set1_epi32(1<<(2*BILINEAR_WEIGHT_BITS-1));
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        uint32_t c00[4],c10[4],c01[4],c11[4];
+        int32_t wX[4],wY[4];
+        fixed_t pX=x+i*xStepX;
+        fixed_t pY=y+i*xStepY;
+        for(int j=0;j<4;j++,pX+=xStepX,pY+=xStepY)
+        {
+            const uint32_t *row=data+fixedToInt(pY)*stride+fixedToInt(pX);
+            c00[j]=row[0];
+            c10[j]=row[1];
+            c01[j]=row[stride];
+            c11[j]=row[stride+1];
+            wX[j]=bilinearWeight(pX);
+            wY[j]=bilinearWeight(pY);
+        }
+
+        __m128i v00=_mm_loadu_si128((const __m128i*)c00);
+        __m128i v10=_mm_loadu_si128((const __m128i*)c10);
+        __m128i v01=_mm_loadu_si128((const __m128i*)c01);
+        __m128i v11=_mm_loadu_si128((const __m128i*)c11);
+        __m128i wXV=_mm_loadu_si128((const __m128i*)wX);
+        __m128i wYV=_mm_loadu_si128((const __m128i*)wY);
+
+        // Vertical weights, replicated over the four 16-bit channels of each pixel
+
+        __m128i wYPair=_mm_or_si128(wYV,_mm_slli_epi32(wYV,16));
+        __m128i wYRPair=_mm_sub_epi16(_mm_set1_epi16(BILINEAR_WEIGHT_ONE),wYPair);
+        __m128i wYLo=_mm_unpacklo_epi32(wYPair,wYPair);
+        __m128i wYHi=_mm_unpackhi_epi32(wYPair,wYPair);
+        __m128i wYRLo=_mm_unpacklo_epi32(wYRPair,wYRPair);
+        __m128i wYRHi=_mm_unpackhi_epi32(wYRPair,wYRPair);
+
+        __m128i leftLo=_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v00,zero),wYRLo),_mm_mullo_epi16(_mm_unpacklo_epi8(v01,zero),wYLo));
+        __m128i leftHi=_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v00,zero),wYRHi),_mm_mullo_epi16(_mm_unpackhi_epi8(v01,zero),wYHi));
+        __m128i rightLo=_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(v10,zero),wYRLo),_mm_mullo_epi16(_mm_unpacklo_epi8(v11,zero),wYLo));
+        __m128i rightHi=_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(v10,zero),wYRHi),_mm_mullo_epi16(_mm_unpackhi_epi8(v11,zero),wYHi));
+
+        // Horizontal blend: (left,right) pairs times (1-wX,wX) pairs, accumulated in 32 bits
+
+        __m128i wXPair=_mm_or_si128(_mm_sub_epi32(_mm_set1_epi32(BILINEAR_WEIGHT_ONE),wXV),_mm_slli_epi32(wXV,16));
+        __m128i r0=_mm_madd_epi16(_mm_unpacklo_epi16(leftLo,rightLo),_mm_shuffle_epi32(wXPair,_MM_SHUFFLE(0,0,0,0)));
+        __m128i r1=_mm_madd_epi16(_mm_unpackhi_epi16(leftLo,rightLo),_mm_shuffle_epi32(wXPair,_MM_SHUFFLE(1,1,1,1)));
+        __m128i r2=_mm_madd_epi16(_mm_unpacklo_epi16(leftHi,rightHi),_mm_shuffle_epi32(wXPair,_MM_SHUFFLE(2,2,2,2)));
+        __m128i r3=_mm_madd_epi16(_mm_unpackhi_epi16(leftHi,rightHi),_mm_shuffle_epi32(wXPair,_MM_SHUFFLE(3,3,3,3)));
+        r0=_mm_srli_epi32(_mm_add_epi32(r0,rounding),2*BILINEAR_WEIGHT_BITS);
+        r1=_mm_srli_epi32(_mm_add_epi32(r1,rounding),2*BILINEAR_WEIGHT_BITS);
+        r2=_mm_srli_epi32(_mm_add_epi32(r2,rounding),2*BILINEAR_WEIGHT_BITS);
+        r3=_mm_srli_epi32(_mm_add_epi32(r3,rounding),2*BILINEAR_WEIGHT_BITS);
+
+        __m128i result=_mm_packus_epi16(_mm_packs_epi32(r0,r1),_mm_packs_epi32(r2,r3));
+        _mm_storeu_si128((__m128i*)(out+i),result);
+    }
+    if(i<count)
+        fixedBilinearInteriorRow(data,width,height,stride,out+i,count-i,x+i*xStepX,y+i*xStepY,xStepX,xStepY);
+}
+
+// Limits the colour channels of four packed pixels to their alpha, as in clampToAlpha() in rotationengine_scalar.cpp
+
+ROTATIONENGINE_TARGET_SSE42 static inline __m128i clampToAlphaSse42(__m128i pixels)
+{
+    const __m128i alphas=_mm_setr_epi8(3,3,3,3,7,7,7,7,11,11,11,11,15,15,15,15);
+    return _mm_min_epu8(pixels,_mm_shuffle_epi8(pixels,alphas));
+}
+
+// Bicubic weighted sum of one source pixel row over 4 taps: pshufb pairs up the channels of neighbouring pixels as 16-bit values,
+// so pmaddwd applies two taps at once. Returns the four channel sums as 32-bit values.
+
+ROTATIONENGINE_TARGET_SSE42 static inline __m128i bicubicRowSse42(const uint32_t *row, __m128i wX01, __m128i wX23)
+{
+    const __m128i pairs01=_mm_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1);
+    const __m128i pairs23=_mm_setr_epi8(8,-1,12,-1,9,-1,13,-1,10,-1,14,-1,11,-1,15,-1);
+
+    __m128i pixels=_mm_loadu_si128((const __m128i*)row);
+    return _mm_add_epi32(_mm_madd_epi16(_mm_shuffle_epi8(pixels,pairs01),wX01),_mm_madd_epi16(_mm_shuffle_epi8(pixels,pairs23),wX23));
+}
+
+// Full 4x4 blend of one destination pixel, shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_SSE42 static inline __m128i bicubicPixelSse42(const uint32_t *pixels, int stride, const int16_t *wX, const int16_t *wY)
+{
+    const int shift=2*BICUBIC_WEIGHT_BITS;
+
+    __m128i wXV=_mm_loadl_epi64((const __m128i*)wX);
+    __m128i wX01=_mm_shuffle_epi32(wXV,_MM_SHUFFLE(0,0,0,0));
+    __m128i wX23=_mm_shuffle_epi32(wXV,_MM_SHUFFLE(1,1,1,1));
+    __m128i wYV=_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wY));
+
+    __m128i sum=_mm_set1_epi32(1<<(shift-1));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(bicubicRowSse42(pixels,wX01,wX23),_mm_shuffle_epi32(wYV,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(bicubicRowSse42(pixels+stride,wX01,wX23),_mm_shuffle_epi32(wYV,_MM_SHUFFLE(1,1,1,1))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(bicubicRowSse42(pixels+2*stride,wX01,wX23),_mm_shuffle_epi32(wYV,_MM_SHUFFLE(2,2,2,2))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(bicubicRowSse42(pixels+3*stride,wX01,wX23),_mm_shuffle_epi32(wYV,_MM_SHUFFLE(3,3,3,3))));
+    return _mm_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::fixedBicubicInteriorRowSse42(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    // Each destination pixel occupies a whole register, with one 32-bit lane per channel; saturating packs clamp the overshoot
+
+    (void)height;
+    const int16_t *weights=bicubicWeights();
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        __m128i r[4];
+        for(int j=0;j<4;j++,x+=xStepX,y+=xStepY)
+        {
+            const uint32_t *pixels=data+(fixedToInt(y)-1)*stride+fixedToInt(x)-1;
+            r[j]=bicubicPixelSse42(pixels,stride,weights+bicubicPhase(x)*4,weights+bicubicPhase(y)*4);
+        }
+        __m128i result=_mm_packus_epi16(_mm_packs_epi32(r[0],r[1]),_mm_packs_epi32(r[2],r[3]));
+        _mm_storeu_si128((__m128i*)(out+i),clampToAlphaSse42(result));
+    }
+    if(i<count)
+        fixedBicubicInteriorRow(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+// Lanczos-3 weighted sum of one source pixel row over 6 taps: pixels 0..3 as in bicubicRowSse42(), pixels 4 and 5 from a 64-bit load
+
+ROTATIONENGINE_TARGET_SSE42 static inline __m128i lanczos3RowSse42(const uint32_t *row, __m128i wX01, __m128i wX23, __m128i wX45)
+{
+    const __m128i pairs01=_mm_setr_epi8(0,-1,4,-1,1,-1,5,-1,2,-1,6,-1,3,-1,7,-1);
+
+    __m128i pixels45=_mm_loadl_epi64((const __m128i*)(row+4));
+    return _mm_add_epi32(bicubicRowSse42(row,wX01,wX23),_mm_madd_epi16(_mm_shuffle_epi8(pixels45,pairs01),wX45));
+}
+
+// Full 6x6 blend of one destination pixel, shifted but not yet clamped
+
+ROTATIONENGINE_TARGET_SSE42 static inline __m128i lanczos3PixelSse42(const uint32_t *pixels, int stride, const int16_t *wX, const int16_t *wY)
+{
+    const int shift=2*LANCZOS_WEIGHT_BITS;
+
+    __m128i wXV=_mm_loadu_si128((const __m128i*)wX);
+    __m128i wX01=_mm_shuffle_epi32(wXV,_MM_SHUFFLE(0,0,0,0));
+    __m128i wX23=_mm_shuffle_epi32(wXV,_MM_SHUFFLE(1,1,1,1));
+    __m128i wX45=_mm_shuffle_epi32(wXV,_MM_SHUFFLE(2,2,2,2));
+    __m128i wYLo=_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)wY));
+    __m128i wYHi=_mm_cvtepi16_epi32(_mm_loadl_epi64((const __m128i*)(wY+4)));
+
+    __m128i sum=_mm_set1_epi32(1<<(shift-1));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels,wX01,wX23,wX45),_mm_shuffle_epi32(wYLo,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels+stride,wX01,wX23,wX45),_mm_shuffle_epi32(wYLo,_MM_SHUFFLE(1,1,1,1))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels+2*stride,wX01,wX23,wX45),_mm_shuffle_epi32(wYLo,_MM_SHUFFLE(2,2,2,2))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels+3*stride,wX01,wX23,wX45),_mm_shuffle_epi32(wYLo,_MM_SHUFFLE(3,3,3,3))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels+4*stride,wX01,wX23,wX45),_mm_shuffle_epi32(wYHi,_MM_SHUFFLE(0,0,0,0))));
+    sum=_mm_add_epi32(sum,_mm_mullo_epi32(lanczos3RowSse42(pixels+5*stride,wX01,wX23,wX45),_mm_shuffle_epi32(wYHi,_MM_SHUFFLE(1,1,1,1))));
+    return _mm_srai_epi32(sum,shift);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::fixedLanczos3InteriorRowSse42(const uint32_t *data, int width, int height, int stride, uint32_t *out, int count, fixed_t x, fixed_t y, fixed_t xStepX, fixed_t xStepY)
+{
+    (void)height;
+    const int16_t *weights=lanczos3Weights();
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        __m128i r[4];
+        for(int j=0;j<4;j++,x+=xStepX,y+=xStepY)
+        {
+            const uint32_t *pixels=data+(fixedToInt(y)-2)*stride+fixedToInt(x)-2;
+            r[j]=lanczos3PixelSse42(pixels,stride,weights+lanczosPhase(x)*LANCZOS_TABLE_STRIDE,weights+lanczosPhase(y)*LANCZOS_TABLE_STRIDE);
+        }
+        __m128i result=_mm_packus_epi16(_mm_packs_epi32(r[0],r[1]),_mm_packs_epi32(r[2],r[3]));
+        _mm_storeu_si128((__m128i*)(out+i),clampToAlphaSse42(result));
+    }
+    if(i<count)
+        fixedLanczos3InteriorRow(data,width,height,stride,out+i,count-i,x,y,xStepX,xStepY);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::shearRowSse42(const uint32_t *in, uint32_t *out, int count, uint32_t weight)
+{
+    const __m128i zero=_mm_setzero_si128();
+    const __m128i weightV=_mm_set1_epi16(weight);
+    const __m128i weightRV=_mm_set1_epi16(BILINEAR_WEIGHT_ONE-weight);
+    const __m128i rounding=_mm_set1_epi16(1<<(BILINEAR_WEIGHT_BITS-1));
+
+    int i=0;
+    for(;i+4<=count;i+=4)
+    {
+        __m128i c0=_mm_loadu_si128((const __m128i*)(in+i));
+        __m128i c1=_mm_loadu_si128((const __m128i*)(in+i+1));
+        __m128i lo=_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(c0,zero),weightRV),_mm_mullo_epi16(_mm_unpacklo_epi8(c1,zero),weightV));
+        __m128i hi=_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(c0,zero),weightRV),_mm_mullo_epi16(_mm_unpackhi_epi8(c1,zero),weightV));
+        lo=_mm_srli_epi16(_mm_add_epi16(lo,rounding),BILINEAR_WEIGHT_BITS);
+        hi=_mm_srli_epi16(_mm_add_epi16(hi,rounding),BILINEAR_WEIGHT_BITS);
+        _mm_storeu_si128((__m128i*)(out+i),_mm_packus_epi16(lo,hi));
+    }
+    if(i<count)
+        shearRow(in+i,out+i,count-i,weight);
+}
+
+// In-register transpose of a 4x4 block of 32-bit pixels: row i becomes column i
+
+ROTATIONENGINE_TARGET_SSE42 static inline void transpose4x4(__m128i *r)
+{
+    __m128i t0=_mm_unpacklo_epi32(r[0],r[1]);
+    __m128i t1=_mm_unpackhi_epi32(r[0],r[1]);
+    __m128i t2=_mm_unpacklo_epi32(r[2],r[3]);
+    __m128i t3=_mm_unpackhi_epi32(r[2],r[3]);
+    r[0]=_mm_unpacklo_epi64(t0,t2);
+    r[1]=_mm_unpackhi_epi64(t0,t2);
+    r[2]=_mm_unpacklo_epi64(t1,t3);
+    r[3]=_mm_unpackhi_epi64(t1,t3);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::transposeBlockSse42(const uint32_t *in, int inStride, uint32_t *out, int outStride, int width, int height)
+{
+    int xBlockEnd=width&~3;
+    int yBlockEnd=height&~3;
+    for(int y=0;y<yBlockEnd;y+=4)
+    {
+        for(int x=0;x<xBlockEnd;x+=4)
+        {
+            __m128i r[4];
+            for(int j=0;j<4;j++)
+                r[j]=_mm_loadu_si128((const __m128i*)(in+(size_t)(y+j)*inStride+x));
+            transpose4x4(r);
+            for(int i=0;i<4;i++)
+                _mm_storeu_si128((__m128i*)(out+(size_t)(x+i)*outStride+y),r[i]);
+        }
+    }
+
+    // Edges that do not fill a whole block
+
+    if(xBlockEnd<width)
+        transposeBlock(in+xBlockEnd,inStride,out+(size_t)xBlockEnd*outStride,outStride,width-xBlockEnd,height);
+    if(yBlockEnd<height)
+        transposeBlock(in+(size_t)yBlockEnd*inStride,inStride,out+yBlockEnd,outStride,xBlockEnd,height-yBlockEnd);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::rotate90RowsSse42(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Destination block (x..x+3,y..y+3) is the transpose of source rows height-1-x..height-4-x, columns y..y+3
+
+    int newWidth=height;
+    int yBlockEnd=yStart+((yEnd-yStart)&~3);
+    int xBlockEnd=newWidth&~3;
+    for(int tileY=yStart;tileY<yBlockEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        int tileYEnd=__min(tileY+TRANSPOSE_TILE_SIZE,yBlockEnd);
+        for(int tileX=0;tileX<xBlockEnd;tileX+=TRANSPOSE_TILE_SIZE)
+        {
+            int tileXEnd=__min(tileX+TRANSPOSE_TILE_SIZE,xBlockEnd);
+            for(int y=tileY;y<tileYEnd;y+=4)
+            {
+                for(int x=tileX;x<tileXEnd;x+=4)
+                {
+                    __m128i r[4];
+                    for(int j=0;j<4;j++)
+                        r[j]=_mm_loadu_si128((const __m128i*)(data+(size_t)(height-1-x-j)*width+y));
+                    transpose4x4(r);
+                    for(int i=0;i<4;i++)
+                        _mm_storeu_si128((__m128i*)(out+(size_t)(y+i)*newWidth+x),r[i]);
+                }
+            }
+        }
+    }
+
+    // Edges that do not fill a whole block
+
+    if(xBlockEnd<newWidth)
+        rotate90Block(data,width,height,out,xBlockEnd,newWidth,yStart,yBlockEnd);
+    if(yBlockEnd<yEnd)
+        rotate90Block(data,width,height,out,0,newWidth,yBlockEnd,yEnd);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::rotate270RowsSse42(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    // Destination block (x..x+3,y..y+3) is the transpose of source rows x..x+3, columns width-4-y..width-1-y, mirrored vertically
+
+    int newWidth=height;
+    int yBlockEnd=yStart+((yEnd-yStart)&~3);
+    int xBlockEnd=newWidth&~3;
+    for(int tileY=yStart;tileY<yBlockEnd;tileY+=TRANSPOSE_TILE_SIZE)
+    {
+        int tileYEnd=__min(tileY+TRANSPOSE_TILE_SIZE,yBlockEnd);
+        for(int tileX=0;tileX<xBlockEnd;tileX+=TRANSPOSE_TILE_SIZE)
+        {
+            int tileXEnd=__min(tileX+TRANSPOSE_TILE_SIZE,xBlockEnd);
+            for(int y=tileY;y<tileYEnd;y+=4)
+            {
+                for(int x=tileX;x<tileXEnd;x+=4)
+                {
+                    __m128i r[4];
+                    for(int j=0;j<4;j++)
+                        r[j]=_mm_loadu_si128((const __m128i*)(data+(size_t)(x+j)*width+(width-4-y)));
+                    transpose4x4(r);
+                    for(int i=0;i<4;i++)
+                        _mm_storeu_si128((__m128i*)(out+(size_t)(y+3-i)*newWidth+x),r[i]);
+                }
+            }
+        }
+    }
+
+    if(xBlockEnd<newWidth)
+        rotate270Block(data,width,height,out,xBlockEnd,newWidth,yStart,yBlockEnd);
+    if(yBlockEnd<yEnd)
+        rotate270Block(data,width,height,out,0,newWidth,yBlockEnd,yEnd);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::reverseRowSse42(const uint32_t *in, uint32_t *out, int count)
+{
+    // Blocks of 4 pixels are read from the end of the input and stored reversed at the start of the output
+
+    int x=0;
+    for(;x+4<=count;x+=4)
+    {
+        __m128i v=_mm_loadu_si128((const __m128i*)(in+count-4-x));
+        _mm_storeu_si128((__m128i*)(out+x),_mm_shuffle_epi32(v,_MM_SHUFFLE(0,1,2,3)));
+    }
+    if(x<count)
+        reverseRow(in,out+x,count-x);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::rotate180RowsSse42(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowSse42(data+(size_t)(height-1-y)*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::flipHorizontallyRowsSse42(const uint32_t *data, int width, int height, uint32_t *out, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowSse42(data+(size_t)y*width,out+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::reverseRowInPlaceSse42(uint32_t *row, int count)
+{
+    // Blocks from both ends are swapped and reversed until they would overlap
+
+    int x=0;
+    for(;x+4<=count-x-4;x+=4)
+    {
+        __m128i a=_mm_loadu_si128((const __m128i*)(row+x));
+        __m128i b=_mm_loadu_si128((const __m128i*)(row+count-x-4));
+        _mm_storeu_si128((__m128i*)(row+x),_mm_shuffle_epi32(b,_MM_SHUFFLE(0,1,2,3)));
+        _mm_storeu_si128((__m128i*)(row+count-x-4),_mm_shuffle_epi32(a,_MM_SHUFFLE(0,1,2,3)));
+    }
+    reverseRowInPlace(row+x,count-2*x);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::reverseSwapRowsSse42(uint32_t *a, uint32_t *b, int count)
+{
+    int x=0;
+    for(;x+4<=count;x+=4)
+    {
+        __m128i va=_mm_loadu_si128((const __m128i*)(a+x));
+        __m128i vb=_mm_loadu_si128((const __m128i*)(b+count-x-4));
+        _mm_storeu_si128((__m128i*)(a+x),_mm_shuffle_epi32(vb,_MM_SHUFFLE(0,1,2,3)));
+        _mm_storeu_si128((__m128i*)(b+count-x-4),_mm_shuffle_epi32(va,_MM_SHUFFLE(0,1,2,3)));
+    }
+    if(x<count)
+        reverseSwapRows(a+x,b,count-x);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::flipHorizontallyInPlaceRowsSse42(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    (void)height;
+    for(int y=yStart;y<yEnd;y++)
+        reverseRowInPlaceSse42(data+(size_t)y*width,width);
+}
+
+ROTATIONENGINE_TARGET_SSE42 void RotationEngine::rotate180InPlaceRowsSse42(uint32_t *data, int width, int height, int yStart, int yEnd)
+{
+    for(int y=yStart;y<yEnd;y++)
+    {
+        int yPos=height-1-y;
+        if(y==yPos)
+            reverseRowInPlaceSse42(data+(size_t)y*width,width);
+        else
+            reverseSwapRowsSse42(data+(size_t)y*width,data+(size_t)yPos*width,width);
+    }
+}
+
+#endif // ROTATIONENGINE_X86
@@ -0,0 +1,213 @@
+#include "rotationengine.h"
+#include <stdio.h>
+
+// Checks of the rotation engine on generated images, so that no image files or Qt are needed.
+// Returns non-zero if any check fails; "make check" runs it.
+
+static int failures=0;
+
+static void check(bool passed, const char *name, int method, int precision, int border, int degs)
+{
+    if(passed)
+        return;
+    printf("FAIL: %s (method %d, precision %d, border %d, %d degrees)\n",name,method,precision,border,degs);
+    failures++;
+}
+
+// Premultiplied pixels with varying alpha, from a fixed pseudo-random sequence
+
+static uint32_t *testImage(int width, int height)
+{
+    uint32_t *data=(uint32_t*)malloc((size_t)width*height*sizeof(uint32_t));
+    uint32_t state=12345;
+    for(int i=0;i<width*height;i++)
+    {
+        state=state*1103515245+12345;
+        uint32_t alpha=(state>>24)|0x80;
+        data[i]=getColor(alpha,((state>>16)&0xff)*alpha/255,((state>>8)&0xff)*alpha/255,(state&0xff)*alpha/255);
+    }
+    return data;
+}
+
+static const int testMethods[]={RotationEngine::NearestNeighbor,RotationEngine::Bilinear,RotationEngine::Bicubic,RotationEngine::Lanczos3};
+static const int testDegs[]={30,135,211,-17};
+#define TEST_COUNT(a) ((int)(sizeof(a)/sizeof(a[0])))
+
+static void testTileSizes()
+{
+    // Tiles only change the order in which pixels are resampled, never their values
+
+    int width=300,height=200;
+    uint32_t *data=testImage(width,height);
+    for(int m=0;m<TEST_COUNT(testMethods);m++)
+    {
+        for(int precision=RotationEngine::DoublePrecision;precision<=RotationEngine::FixedPoint;precision++)
+        {
+            for(int border=0;border<BORDER_MODE_COUNT;border++)
+            {
+                for(int d=0;d<TEST_COUNT(testDegs);d++)
+                {
+                    int newWidth,newHeight,otherWidth,otherHeight;
+                    RotationEngine::setTileSize(16);
+                    uint32_t *small=RotationEngine::rotate(data,width,height,testDegs[d],testMethods[m],precision,newWidth,newHeight,border,0xff204060);
+                    RotationEngine::setTileSize(80);
+                    uint32_t *large=RotationEngine::rotate(data,width,height,testDegs[d],testMethods[m],precision,otherWidth,otherHeight,border,0xff204060);
+                    check(newWidth==otherWidth&&newHeight==otherHeight&&memcmp(small,large,(size_t)newWidth*newHeight*sizeof(uint32_t))==0,
+                          "tile size changes the output",testMethods[m],precision,border,testDegs[d]);
+                    free(small);
+                    free(large);
+                }
+            }
+        }
+    }
+    RotationEngine::setTileSize(0);
+    free(data);
+}
+
+static void testRegions()
+{
+    // A region has the pixels of the same window of rotate(), wherever it starts. The windows also reach beyond each edge of the
+    // output, where they are not compared: the size of the output is rounded, so a corner of the mapping may be cut off.
+
+    static const int windows[][4]={{0,0,64,48},{37,23,101,77},{-9,-5,50,40},{150,120,400,300}};
+    int width=300,height=200;
+    uint32_t *data=testImage(width,height);
+    for(int m=0;m<TEST_COUNT(testMethods);m++)
+    {
+        for(int precision=RotationEngine::DoublePrecision;precision<=RotationEngine::FixedPoint;precision++)
+        {
+            for(int d=0;d<TEST_COUNT(testDegs)+1;d++)
+            {
+                int degs=d<TEST_COUNT(testDegs)?testDegs[d]:90;
+                int newWidth,newHeight;
+                uint32_t *full=RotationEngine::rotate(data,width,height,degs,testMethods[m],precision,newWidth,newHeight);
+                for(int w=0;w<TEST_COUNT(windows);w++)
+                {
+                    int x=windows[w][0],y=windows[w][1],regionWidth=windows[w][2],regionHeight=windows[w][3];
+                    uint32_t *region=RotationEngine::rotateRegion(data,width,height,degs,testMethods[m],precision,x,y,regionWidth,regionHeight);
+                    bool same=true;
+                    for(int fullY=__max(y,0);fullY<__min(y+regionHeight,newHeight);fullY++)
+                    {
+                        for(int fullX=__max(x,0);fullX<__min(x+regionWidth,newWidth);fullX++)
+                            same&=region[(size_t)(fullY-y)*regionWidth+fullX-x]==full[(size_t)fullY*newWidth+fullX];
+                    }
+                    check(same,"region differs from the output of rotate()",testMethods[m],precision,RotationEngine::BorderTransparent,degs);
+                    free(region);
+                }
+                free(full);
+            }
+        }
+    }
+    free(data);
+}
+
+static uint32_t clampedPixel(const uint32_t *data, int width, int height, int x, int y)
+{
+    return data[(size_t)__min(y,height-1)*width+__min(x,width-1)];
+}
+
+static void testHalveImage()
+{
+    // Halving odd sizes repeats the last row or column, through the guard band. Each level is halved again as the display's
+    // pyramid does, down to a single pixel, so the guard band of the halved images is checked too.
+
+    static const int sizes[][2]={{1,1},{1,7},{7,1},{2,2},{5,3},{6,4},{33,17}};
+    for(int s=0;s<TEST_COUNT(sizes);s++)
+    {
+        int width=sizes[s][0],height=sizes[s][1];
+        uint32_t *data=testImage(width,height);
+        SourceImage image;
+        uint32_t *buffer=RotationEngine::padImage(data,width,height,image);
+        while(width>1||height>1)
+        {
+            SourceImage halved;
+            uint32_t *halvedBuffer=RotationEngine::halveImage(image,halved);
+            int halvedWidth=(width+1)/2,halvedHeight=(height+1)/2;
+            bool same=halved.width==halvedWidth&&halved.height==halvedHeight;
+            uint32_t *expected=(uint32_t*)malloc((size_t)halvedWidth*halvedHeight*sizeof(uint32_t));
+            for(int y=0;same&&y<halvedHeight;y++)
+            {
+                for(int x=0;x<halvedWidth;x++)
+                {
+                    uint32_t pixels[4]={clampedPixel(data,width,height,2*x,2*y),clampedPixel(data,width,height,2*x+1,2*y),
+                                        clampedPixel(data,width,height,2*x,2*y+1),clampedPixel(data,width,height,2*x+1,2*y+1)};
+                    uint32_t pixel=0;
+                    for(int byte=0;byte<4;byte++)
+                        pixel|=((getByte(pixels[0],byte)+getByte(pixels[1],byte)+getByte(pixels[2],byte)+getByte(pixels[3],byte)+2)>>2)<<(byte*8);
+                    expected[(size_t)y*halvedWidth+x]=pixel;
+
+                    // The guard band repeats the nearest pixel of the image
+
+                    same&=halved.data[(size_t)y*halved.stride+x]==pixel;
+                    for(int j=-GUARD_BAND;j<=GUARD_BAND;j++)
+                    {
+                        for(int i=-GUARD_BAND;i<=GUARD_BAND;i++)
+                        {
+                            int guardX=x+i,guardY=y+j;
+                            if(guardX>=0&&guardX<halvedWidth&&guardY>=0&&guardY<halvedHeight)
+                                continue;
+                            int nearestX=__min(__max(guardX,0),halvedWidth-1),nearestY=__min(__max(guardY,0),halvedHeight-1);
+                            if(nearestX==x&&nearestY==y)
+                                same&=halved.data[guardY*halved.stride+guardX]==pixel;
+                        }
+                    }
+                }
+            }
+            if(!same)
+            {
+                printf("FAIL: halving a %dx%d image\n",width,height);
+                failures++;
+            }
+            free(data);
+            free(buffer);
+            data=expected;
+            buffer=halvedBuffer;
+            image=halved;
+            width=halvedWidth;
+            height=halvedHeight;
+        }
+        free(data);
+        free(buffer);
+    }
+}
+
+static void testSimdLevels()
+{
+    // Every SIMD level gives the same pixels. The sizes are not multiples of the vector widths, so the scalar edges run too.
+
+    int width=203,height=117;
+    uint32_t *data=testImage(width,height);
+    int detectedLevel=RotationEngine::detectSimdLevel();
+    for(int m=0;m<METHOD_COUNT;m++)
+    {
+        for(int d=0;d<TEST_COUNT(testDegs);d++)
+        {
+            RotationEngine::setSimdLevel(RotationEngine::SimdScalar);
+            int newWidth,newHeight;
+            uint32_t *reference=RotationEngine::rotate(data,width,height,testDegs[d],m,RotationEngine::FixedPoint,newWidth,newHeight);
+            for(int level=RotationEngine::SimdScalar+1;level<=detectedLevel;level++)
+            {
+                RotationEngine::setSimdLevel(level);
+                int otherWidth,otherHeight;
+                uint32_t *result=RotationEngine::rotate(data,width,height,testDegs[d],m,RotationEngine::FixedPoint,otherWidth,otherHeight);
+                check(newWidth==otherWidth&&newHeight==otherHeight&&memcmp(reference,result,(size_t)newWidth*newHeight*sizeof(uint32_t))==0,
+                      "SIMD level changes the output",m,RotationEngine::FixedPoint,RotationEngine::BorderTransparent,testDegs[d]);
+                free(result);
+            }
+            free(reference);
+        }
+    }
+    RotationEngine::setSimdLevel(detectedLevel);
+    free(data);
+}
+
+int main()
+{
+    testTileSizes();
+    testRegions();
+    testHalveImage();
+    testSimdLevels();
+    if(failures==0)
+        printf("All checks passed\n");
+    return failures!=0;
+}
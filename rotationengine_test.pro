@@ -0,0 +1,30 @@
+#-------------------------------------------------
+#
+# Checks of the rotation engine; "make check" runs them
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = rotationengine_test
+TEMPLATE = app
+CONFIG += console testcase c++11 thread
+CONFIG -= app_bundle
+
+SOURCES += rotationengine_test.cpp
+
+HEADERS += rotationengine.h \
+    extcolordefs.h
+
+win32:CONFIG(release, debug|release): LIBS += -L$$OUT_PWD/release/ -lrotationengine
+else:win32:CONFIG(debug, debug|release): LIBS += -L$$OUT_PWD/debug/ -lrotationengine
+else:unix: LIBS += -L$$OUT_PWD/ -lrotationengine
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/librotationengine.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/librotationengine.a
+else:win32:!win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += $$OUT_PWD/release/rotationengine.lib
+else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$OUT_PWD/debug/rotationengine.lib
+else:unix: PRE_TARGETDEPS += $$OUT_PWD/librotationengine.a
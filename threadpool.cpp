@@ -0,0 +1,127 @@
+#include "threadpool.h"
+#include "extcolordefs.h"
+
+// Set while the thread processes a band, so that nested run() calls neither wait for runMutex nor for busy workers
+
+static thread_local bool inBand=false;
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    job=0;
+    jobCount=0;
+    jobBandSize=1;
+    nextBand=0;
+    bandCount=0;
+    generation=0;
+    busyWorkers=0;
+    stopping=false;
+
+    // The thread calling run() is the first worker
+
+    for(int i=1;i<threadCount;i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop,this));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping=true;
+    }
+    wakeCondition.notify_all();
+    for(size_t i=0;i<workers.size();i++)
+        workers[i].join();
+}
+
+int ThreadPool::threadCount() const
+{
+    return (int)workers.size()+1;
+}
+
+void ThreadPool::run(int count, int minBandSize, const std::function<void(int,int)> &func)
+{
+    if(count<=0)
+        return;
+    if(inBand)
+    {
+        func(0,count);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(runMutex);
+
+    // About four bands per thread, so that threads finishing early can pick up remaining work
+
+    int threads=threadCount();
+    int bandSize=__max(minBandSize,(count+threads*4-1)/(threads*4));
+    if(bandSize<1)
+        bandSize=1;
+    int bands=(count+bandSize-1)/bandSize;
+
+    if(bands==1||workers.empty())
+    {
+        inBand=true;
+        func(0,count);
+        inBand=false;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job=&func;
+        jobCount=count;
+        jobBandSize=bandSize;
+        bandCount=bands;
+        nextBand=0;
+        busyWorkers=(int)workers.size();
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    processBands();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(busyWorkers>0)
+        doneCondition.wait(lock);
+    job=0;
+}
+
+void ThreadPool::processBands()
+{
+    for(;;)
+    {
+        int band=nextBand.fetch_add(1);
+        if(band>=bandCount)
+            return;
+        int start=band*jobBandSize;
+        int end=__min(start+jobBandSize,jobCount);
+        inBand=true;
+        (*job)(start,end);
+        inBand=false;
+    }
+}
+
+void ThreadPool::workerLoop()
+{
+    int seenGeneration=0;
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!stopping&&generation==seenGeneration)
+                wakeCondition.wait(lock);
+            if(stopping)
+                return;
+            seenGeneration=generation;
+        }
+
+        processBands();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+            if(busyWorkers==0)
+                doneCondition.notify_one();
+        }
+    }
+}
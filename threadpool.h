@@ -0,0 +1,44 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+// Persistent pool of worker threads used by the rotation engine. Threads are created once and reused by every call to run().
+
+class ThreadPool
+{
+    std::vector<std::thread> workers;
+    std::mutex runMutex; // Serializes run() calls
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    const std::function<void(int,int)> *job;
+    int jobCount;
+    int jobBandSize;
+    std::atomic<int> nextBand;
+    int bandCount;
+    int generation;
+    int busyWorkers;
+    bool stopping;
+
+    void workerLoop();
+    void processBands();
+
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    int threadCount() const;
+
+    // Splits [0,count) into bands of at least minBandSize items and calls func(start,end) for each of them.
+    // The calling thread takes part; returns once all bands are done. Calls made from inside a band, of this pool or another one,
+    // run func(0,count) on the calling thread instead, since the workers are busy with the outer call.
+    void run(int count,int minBandSize,const std::function<void(int,int)> &func);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,298 @@
+#include "tiledimageitem.h"
+#include "rotationengine.h"
+#include "extcolordefs.h"
+#include <math.h>
+
+TiledImageItem::TiledImageItem(QGraphicsItem *parent)
+    : QGraphicsObject(parent)
+{
+    imageWidth=0;
+    imageHeight=0;
+    tiles.setMaxCost(TILE_CACHE_BUDGET);
+    generation=0;
+    for(int i=0;i<RENDER_LEVELS;i++)
+        levelVersions[i]=0;
+    rendering=false;
+    stopping=false;
+    cancelled=false;
+
+    // exposedRect is only set to the area being repainted with this flag; otherwise it covers the whole item
+
+    setFlag(ItemUsesExtendedStyleOption);
+    worker=std::thread(&TiledImageItem::workerLoop,this);
+}
+
+TiledImageItem::~TiledImageItem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping=true;
+        cancelled=true;
+    }
+    wakeCondition.notify_all();
+    worker.join();
+    for(int i=0;i<renderedTiles.size();i++)
+        free(renderedTiles[i].data);
+}
+
+quint64 TiledImageItem::tileKey(int level, int column, int row)
+{
+    return ((quint64)level<<48)|((quint64)row<<24)|(quint64)column;
+}
+
+int TiledImageItem::scaleLevel(double scale)
+{
+    int level=0;
+    for(double s=scale;s<1.0;s*=2.0)
+        level++;
+    return level;
+}
+
+void TiledImageItem::startGeneration()
+{
+    // Called with the mutex held. The worker resets the flag when it takes the next request.
+
+    generation++;
+    requests.clear();
+    pendingKeys.clear();
+    cancelled=true;
+}
+
+void TiledImageItem::setImage(int width, int height, const RenderFunc &render)
+{
+    prepareGeometryChange();
+    imageWidth=width;
+    imageHeight=height;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->render=render;
+        startGeneration();
+    }
+    tiles.clear();
+    staleKeys.clear();
+    update();
+}
+
+void TiledImageItem::clear()
+{
+    setImage(0,0,RenderFunc());
+    std::unique_lock<std::mutex> lock(mutex);
+    while(rendering)
+        idleCondition.wait(lock);
+}
+
+void TiledImageItem::refreshTiles(double maxScale)
+{
+    // Nothing is cancelled and the queue is kept, as the render function reads the image only once the worker takes a request.
+    // Of the tiles at these scales, only those taken before this call are thus delivered stale, to be requested again.
+
+    int minLevel=scaleLevel(maxScale);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(int level=minLevel;level<RENDER_LEVELS;level++)
+            levelVersions[level]++;
+    }
+    QList<quint64> keys=tiles.keys();
+    for(int i=0;i<keys.size();i++)
+    {
+        if((int)(keys[i]>>48)>=minLevel)
+            staleKeys.insert(keys[i]);
+    }
+    update();
+}
+
+void TiledImageItem::requestTile(const TileRequest &request)
+{
+    // A tile requested again moves to the front of the queue
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(pendingKeys.contains(request.key))
+        {
+            for(int i=0;i<requests.size();i++)
+            {
+                if(requests[i].key==request.key)
+                {
+                    requests.move(i,requests.size()-1);
+                    break;
+                }
+            }
+            return;
+        }
+        pendingKeys.insert(request.key);
+        requests.append(request);
+    }
+    wakeCondition.notify_one();
+}
+
+void TiledImageItem::workerLoop()
+{
+    RotationEngine::setCancelFlag(&cancelled);
+    std::unique_lock<std::mutex> lock(mutex);
+    for(;;)
+    {
+        while(!stopping&&requests.isEmpty())
+            wakeCondition.wait(lock);
+        if(stopping)
+            return;
+
+        TileRequest request=requests.takeLast();
+        request.version=levelVersions[request.key>>48];
+        int requestGeneration=generation;
+        RenderFunc renderTile=render;
+        rendering=true;
+        cancelled=false;
+        lock.unlock();
+
+        uint32_t *data=renderTile(request.scale,request.x,request.y,request.width,request.height);
+
+        lock.lock();
+        rendering=false;
+        idleCondition.notify_all();
+        if(data==0)
+            continue;
+        if(requestGeneration!=generation)
+        {
+            free(data);
+            continue;
+        }
+
+        // One queued call delivers all tiles finished until the GUI thread gets to it
+
+        RenderedTile tile;
+        tile.request=request;
+        tile.generation=requestGeneration;
+        tile.data=data;
+        renderedTiles.append(tile);
+        if(renderedTiles.size()==1)
+            QMetaObject::invokeMethod(this,"deliverTiles",Qt::QueuedConnection);
+    }
+}
+
+void TiledImageItem::deliverTiles()
+{
+    QList<RenderedTile> delivered;
+    int currentGeneration;
+    int currentVersions[RENDER_LEVELS];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        delivered.swap(renderedTiles);
+        currentGeneration=generation;
+        for(int i=0;i<RENDER_LEVELS;i++)
+            currentVersions[i]=levelVersions[i];
+        for(int i=0;i<delivered.size();i++)
+        {
+            if(delivered[i].generation==currentGeneration)
+                pendingKeys.remove(delivered[i].request.key);
+        }
+    }
+
+    // Pixmaps may share the rendered buffer, which the image frees with them
+
+    for(int i=0;i<delivered.size();i++)
+    {
+        const TileRequest &request=delivered[i].request;
+        if(delivered[i].generation!=currentGeneration)
+        {
+            free(delivered[i].data);
+            continue;
+        }
+        QImage image((uchar*)delivered[i].data,request.width,request.height,request.width*sizeof(uint32_t),QImage::Format_ARGB32_Premultiplied,free,delivered[i].data);
+        tiles.insert(request.key,new QPixmap(QPixmap::fromImage(image)),request.width*request.height*4);
+        if(request.version==currentVersions[request.key>>48])
+            staleKeys.remove(request.key);
+        else
+            staleKeys.insert(request.key);
+        update(QRectF(request.x/request.scale,request.y/request.scale,request.width/request.scale,request.height/request.scale));
+    }
+}
+
+double TiledImageItem::renderScale(double zoom)
+{
+    // Powers of two, so that zooming only renders new tiles when it crosses one. Zooming in beyond full size is left to the painter.
+
+    double scale=1.0;
+    while(scale>MIN_RENDER_SCALE&&scale*0.5>=zoom)
+        scale*=0.5;
+    return scale;
+}
+
+QRectF TiledImageItem::boundingRect() const
+{
+    return QRectF(0,0,imageWidth,imageHeight);
+}
+
+void TiledImageItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    (void)widget;
+    if(imageWidth<=0||imageHeight<=0)
+        return;
+
+    // Item coordinates are full-size pixels; the scaled image covers them with pixels 1/scale wide
+
+    double scale=renderScale(QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
+    int level=scaleLevel(scale);
+    int scaledWidth=__max((int)ceil(imageWidth*scale),1);
+    int scaledHeight=__max((int)ceil(imageHeight*scale),1);
+
+    QRectF exposed=option->exposedRect&boundingRect();
+    int firstColumn=__max((int)floor(exposed.left()*scale/TILE_SIZE),0);
+    int firstRow=__max((int)floor(exposed.top()*scale/TILE_SIZE),0);
+    int lastColumn=__min((int)ceil(exposed.right()*scale/TILE_SIZE),(scaledWidth+TILE_SIZE-1)/TILE_SIZE)-1;
+    int lastRow=__min((int)ceil(exposed.bottom()*scale/TILE_SIZE),(scaledHeight+TILE_SIZE-1)/TILE_SIZE)-1;
+
+    for(int row=firstRow;row<=lastRow;row++)
+    {
+        for(int column=firstColumn;column<=lastColumn;column++)
+        {
+            int x=column*TILE_SIZE;
+            int y=row*TILE_SIZE;
+            int width=__min(TILE_SIZE,scaledWidth-x);
+            int height=__min(TILE_SIZE,scaledHeight-y);
+
+            // The scaled size is rounded up, so the last pixels may reach beyond the image; that part is left out, as nothing
+            // may be painted outside boundingRect()
+
+            QRectF target(x/scale,y/scale,__min(width/scale,imageWidth-x/scale),__min(height/scale,imageHeight-y/scale));
+            double sourceWidth=target.width()*scale;
+            double sourceHeight=target.height()*scale;
+
+            // object() also marks the tile as most recently used
+
+            quint64 key=tileKey(level,column,row);
+            TileRequest request;
+            request.key=key;
+            request.scale=scale;
+            request.x=x;
+            request.y=y;
+            request.width=width;
+            request.height=height;
+            QPixmap *cached=tiles.object(key);
+            if(cached!=0)
+            {
+                painter->setRenderHint(QPainter::SmoothPixmapTransform,scale<1.0);
+                painter->drawPixmap(target,*cached,QRectF(0,0,sourceWidth,sourceHeight));
+                if(staleKeys.contains(key))
+                    requestTile(request);
+                continue;
+            }
+            requestTile(request);
+
+            // Until it arrives, the part of the nearest coarser tile covering it is enlarged in its place
+
+            int coarseLevel=level;
+            for(double coarseScale=scale*0.5;coarseScale>=MIN_RENDER_SCALE;coarseScale*=0.5)
+            {
+                coarseLevel++;
+                int shift=coarseLevel-level;
+                QPixmap *coarse=tiles.object(tileKey(coarseLevel,column>>shift,row>>shift));
+                if(coarse==0)
+                    continue;
+                double factor=coarseScale/scale;
+                painter->setRenderHint(QPainter::SmoothPixmapTransform,true);
+                painter->drawPixmap(target,*coarse,QRectF(x*factor-(column>>shift)*TILE_SIZE,y*factor-(row>>shift)*TILE_SIZE,sourceWidth*factor,sourceHeight*factor));
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef TILEDIMAGEITEM_H
+#define TILEDIMAGEITEM_H
+
+#include <QGraphicsObject>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QPixmap>
+#include <QCache>
+#include <QList>
+#include <QSet>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+// Tiles are rendered at no less than this fraction of the full size
+
+#define MIN_RENDER_SCALE (1.0/64)
+#define RENDER_LEVELS 7 // Scales from 1 down to MIN_RENDER_SCALE
+#define TILE_SIZE 256 // Pixels of the rendered resolution
+#define TILE_CACHE_BUDGET (128*1024*1024) // Bytes of cached tile pixmaps
+
+// Displays an image that is only rendered where it is seen: paint() requests the tiles intersecting the exposed area, at the resolution
+// the zoom of the view requires, and caches them until the image changes or the budget evicts them, least recently used first.
+// Painting thus costs in proportion to the viewport, whatever the size of the image.
+//
+// Tiles are rendered on a worker thread, so painting never waits for them: a missing tile is stood in for by a coarser cached one,
+// if any, and painted once it arrives. Every change of the image starts a new generation, which drops the requests of the previous
+// one, cancels the tile being rendered between bands of rows and discards whatever of it still finishes.
+//
+// Tiles that are still correct but could now be rendered better are marked stale instead: they stay on screen, and are requested
+// again when painted, until a tile rendered after they were marked replaces them.
+
+class TiledImageItem : public QGraphicsObject
+{
+    Q_OBJECT
+
+public:
+    // Renders the width*height pixels at (x,y) of the image scaled by "scale", as a malloc()ed buffer of premultiplied pixels.
+    // Called on the worker thread, so it must only use state captured when the image was set.
+    typedef std::function<uint32_t*(double scale,int x,int y,int width,int height)> RenderFunc;
+
+private:
+    struct TileRequest
+    {
+        quint64 key;
+        double scale;
+        int x,y,width,height; // Pixels of the scaled image
+        int version; // levelVersions[] of the scale when the worker took the request
+    };
+
+    struct RenderedTile
+    {
+        TileRequest request;
+        int generation;
+        uint32_t *data;
+    };
+
+    int imageWidth,imageHeight;
+    QCache<quint64,QPixmap> tiles; // Keyed by tileKey(); the cost of a tile is its size in bytes
+    QSet<quint64> staleKeys; // Cached tiles to be replaced, see refreshTiles()
+
+    std::thread worker;
+    std::mutex mutex; // Guards the members below
+    std::condition_variable wakeCondition;
+    std::condition_variable idleCondition;
+    RenderFunc render;
+    int generation;
+    int levelVersions[RENDER_LEVELS]; // Count the refreshTiles() calls affecting each scale
+    QList<TileRequest> requests; // The worker takes the last one first, i.e. the tiles painted most recently
+    QSet<quint64> pendingKeys; // Requested or being rendered in this generation
+    QList<RenderedTile> renderedTiles; // Waiting for deliverTiles()
+    bool rendering;
+    bool stopping;
+    std::atomic<bool> cancelled; // Cancel flag of the worker's renders, see RotationEngine::setCancelFlag()
+
+    static int scaleLevel(double scale); // n for a render scale of 1/2^n
+    static quint64 tileKey(int level,int column,int row);
+    void startGeneration();
+    void requestTile(const TileRequest &request);
+    void workerLoop();
+
+private slots:
+    void deliverTiles();
+
+public:
+    explicit TiledImageItem(QGraphicsItem *parent=0);
+    ~TiledImageItem();
+
+    void setImage(int width,int height,const RenderFunc &render); // Full size; also drops all tiles, as the image changed
+    void clear(); // Shows nothing, and returns once the worker no longer renders
+    void refreshTiles(double maxScale); // Renders the tiles at maxScale and below again when they are next painted, showing the old ones meanwhile
+    static double renderScale(double zoom); // The smallest power of two not below zoom, within [MIN_RENDER_SCALE,1]
+
+    QRectF boundingRect() const;
+    void paint(QPainter *painter,const QStyleOptionGraphicsItem *option,QWidget *widget);
+};
+
+#endif // TILEDIMAGEITEM_H